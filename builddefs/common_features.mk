@@ -44,6 +44,37 @@ else ifeq ($(strip $(DEBUG_MATRIX_SCAN_RATE_ENABLE)), api)
     OPT_DEFS += -DDEBUG_MATRIX_SCAN_RATE
 endif
 
+ifeq ($(strip $(PROFILE_ZONES_ENABLE)), yes)
+    OPT_DEFS += -DPROFILE_ZONES_ENABLE
+    BASIC_PROFILING_REQUIRED := yes
+endif
+
+ifeq ($(strip $(TASK_SCHEDULER_ENABLE)), yes)
+    OPT_DEFS += -DTASK_SCHEDULER_ENABLE
+    QUANTUM_SRC += $(QUANTUM_DIR)/task_scheduler.c
+    BASIC_PROFILING_REQUIRED := yes
+endif
+
+ifeq ($(strip $(THREADED_TASKS_ENABLE)), yes)
+    ifneq ($(PLATFORM),CHIBIOS)
+        $(call CATASTROPHIC_ERROR,Invalid THREADED_TASKS_ENABLE,THREADED_TASKS_ENABLE is only supported on ChibiOS)
+    endif
+    ifeq ($(strip $(TASK_SCHEDULER_ENABLE)), yes)
+        $(call CATASTROPHIC_ERROR,Invalid THREADED_TASKS_ENABLE,THREADED_TASKS_ENABLE and TASK_SCHEDULER_ENABLE cannot be used together)
+    endif
+    OPT_DEFS += -DTHREADED_TASKS_ENABLE
+endif
+
+ifeq ($(strip $(BASIC_PROFILING_REQUIRED)), yes)
+    QUANTUM_SRC += $(QUANTUM_DIR)/basic_profiling.c
+endif
+
+ifeq ($(strip $(CONSOLE_TRACE_ENABLE)), yes)
+    OPT_DEFS += -DCONSOLE_TRACE_ENABLE
+    QUANTUM_SRC += $(QUANTUM_DIR)/logging/console_trace.c
+    CONSOLE_ENABLE = yes
+endif
+
 AUDIO_ENABLE ?= no
 ifeq ($(strip $(AUDIO_ENABLE)), yes)
     ifeq ($(PLATFORM),CHIBIOS)
@@ -52,6 +83,7 @@ ifeq ($(strip $(AUDIO_ENABLE)), yes)
             OPT_DEFS += -DAUDIO_DRIVER_DAC
         else ifeq ($(strip $(AUDIO_DRIVER)), dac_additive)
             OPT_DEFS += -DAUDIO_DRIVER_DAC
+            SRC += $(QUANTUM_DIR)/audio/synth.c
         ## stm32f2 and above have a usable DAC unit, f1 do not, and need to use pwm instead
         else ifeq ($(strip $(AUDIO_DRIVER)), pwm_software)
             OPT_DEFS += -DAUDIO_DRIVER_PWM
@@ -86,8 +118,6 @@ ifeq ($(strip $(MIDI_ENABLE)), yes)
     SRC += $(QUANTUM_DIR)/midi/midi_device.c
     SRC += $(QUANTUM_DIR)/midi/qmk_midi.c
     SRC += $(QUANTUM_DIR)/midi/sysex_tools.c
-    SRC += $(QUANTUM_DIR)/midi/bytequeue/bytequeue.c
-    SRC += $(QUANTUM_DIR)/midi/bytequeue/interrupt_setting.c
     SRC += $(QUANTUM_DIR)/process_keycode/process_midi.c
 endif
 
@@ -116,6 +146,11 @@ ifeq ($(strip $(STENO_ENABLE)), yes)
     endif
 endif
 
+ifneq ($(filter yes,$(strip $(MIDI_ENABLE)) $(strip $(VIRTSER_ENABLE))),)
+    COMMON_VPATH += $(QUANTUM_PATH)/midi/bytequeue
+    SRC += $(QUANTUM_DIR)/midi/bytequeue/bytequeue.c
+endif
+
 ifeq ($(strip $(MOUSEKEY_ENABLE)), yes)
     MOUSE_ENABLE := yes
 endif
@@ -355,41 +390,48 @@ ifeq ($(strip $(LED_MATRIX_ENABLE)), yes)
     SRC += $(QUANTUM_DIR)/process_keycode/process_backlight.c
     SRC += $(QUANTUM_DIR)/led_matrix/led_matrix.c
     SRC += $(QUANTUM_DIR)/led_matrix/led_matrix_drivers.c
+    LED_ENGINE_REQUIRED := yes
     LIB8TION_ENABLE := yes
     CIE1931_CURVE := yes
 
     ifeq ($(strip $(LED_MATRIX_DRIVER)), is31fl3218)
         I2C_DRIVER_REQUIRED = yes
+        LED_PWM_BUFFER_REQUIRED = yes
         COMMON_VPATH += $(DRIVER_PATH)/led/issi
         SRC += is31fl3218-simple.c
     endif
 
     ifeq ($(strip $(LED_MATRIX_DRIVER)), is31fl3731)
         I2C_DRIVER_REQUIRED = yes
+        LED_PWM_BUFFER_REQUIRED = yes
         COMMON_VPATH += $(DRIVER_PATH)/led/issi
         SRC += is31fl3731-simple.c
     endif
 
     ifeq ($(strip $(LED_MATRIX_DRIVER)), is31fl3733)
         I2C_DRIVER_REQUIRED = yes
+        LED_PWM_BUFFER_REQUIRED = yes
         COMMON_VPATH += $(DRIVER_PATH)/led/issi
         SRC += is31fl3733-simple.c
     endif
 
     ifeq ($(strip $(LED_MATRIX_DRIVER)), is31fl3736)
         I2C_DRIVER_REQUIRED = yes
+        LED_PWM_BUFFER_REQUIRED = yes
         COMMON_VPATH += $(DRIVER_PATH)/led/issi
         SRC += is31fl3736-simple.c
     endif
 
     ifeq ($(strip $(LED_MATRIX_DRIVER)), is31fl3737)
         I2C_DRIVER_REQUIRED = yes
+        LED_PWM_BUFFER_REQUIRED = yes
         COMMON_VPATH += $(DRIVER_PATH)/led/issi
         SRC += is31fl3737-simple.c
     endif
 
     ifeq ($(strip $(LED_MATRIX_DRIVER)), is31fl3741)
         I2C_DRIVER_REQUIRED = yes
+        LED_PWM_BUFFER_REQUIRED = yes
         COMMON_VPATH += $(DRIVER_PATH)/led/issi
         SRC += is31fl3741-simple.c
     endif
@@ -397,6 +439,7 @@ ifeq ($(strip $(LED_MATRIX_ENABLE)), yes)
     ifeq ($(strip $(LED_MATRIX_DRIVER)), is31fl3742a)
         OPT_DEFS += -DIS31FLCOMMON
         I2C_DRIVER_REQUIRED = yes
+        LED_PWM_BUFFER_REQUIRED = yes
         COMMON_VPATH += $(DRIVER_PATH)/led/issi
         SRC += is31flcommon.c
     endif
@@ -404,6 +447,7 @@ ifeq ($(strip $(LED_MATRIX_ENABLE)), yes)
     ifeq ($(strip $(LED_MATRIX_DRIVER)), is31fl3743a)
         OPT_DEFS += -DIS31FLCOMMON
         I2C_DRIVER_REQUIRED = yes
+        LED_PWM_BUFFER_REQUIRED = yes
         COMMON_VPATH += $(DRIVER_PATH)/led/issi
         SRC += is31flcommon.c
     endif
@@ -411,6 +455,7 @@ ifeq ($(strip $(LED_MATRIX_ENABLE)), yes)
     ifeq ($(strip $(LED_MATRIX_DRIVER)), is31fl3745)
         OPT_DEFS += -DIS31FLCOMMON
         I2C_DRIVER_REQUIRED = yes
+        LED_PWM_BUFFER_REQUIRED = yes
         COMMON_VPATH += $(DRIVER_PATH)/led/issi
         SRC += is31flcommon.c
     endif
@@ -418,18 +463,21 @@ ifeq ($(strip $(LED_MATRIX_ENABLE)), yes)
     ifeq ($(strip $(LED_MATRIX_DRIVER)), is31fl3746a)
         OPT_DEFS += -DIS31FLCOMMON
         I2C_DRIVER_REQUIRED = yes
+        LED_PWM_BUFFER_REQUIRED = yes
         COMMON_VPATH += $(DRIVER_PATH)/led/issi
         SRC += is31flcommon.c
     endif
 
     ifeq ($(strip $(LED_MATRIX_DRIVER)), snled27351)
         I2C_DRIVER_REQUIRED = yes
+        LED_PWM_BUFFER_REQUIRED = yes
         COMMON_VPATH += $(DRIVER_PATH)/led
         SRC += snled27351-simple.c
     endif
 
     ifeq ($(strip $(LED_MATRIX_DRIVER)), snled27351_spi)
 	SPI_DRIVER_REQUIRED = yes
+        LED_PWM_BUFFER_REQUIRED = yes
         COMMON_VPATH += $(DRIVER_PATH)/led
         SRC += snled27351-simple-spi.c
     endif
@@ -461,6 +509,7 @@ ifeq ($(strip $(RGB_MATRIX_ENABLE)), yes)
     SRC += $(QUANTUM_DIR)/color.c
     SRC += $(QUANTUM_DIR)/rgb_matrix/rgb_matrix.c
     SRC += $(QUANTUM_DIR)/rgb_matrix/rgb_matrix_drivers.c
+    LED_ENGINE_REQUIRED := yes
     LIB8TION_ENABLE := yes
     CIE1931_CURVE := yes
     RGB_KEYCODES_ENABLE := yes
@@ -473,36 +522,42 @@ ifeq ($(strip $(RGB_MATRIX_ENABLE)), yes)
 
     ifeq ($(strip $(RGB_MATRIX_DRIVER)), is31fl3218)
         I2C_DRIVER_REQUIRED = yes
+        LED_PWM_BUFFER_REQUIRED = yes
         COMMON_VPATH += $(DRIVER_PATH)/led/issi
         SRC += is31fl3218.c
     endif
 
     ifeq ($(strip $(RGB_MATRIX_DRIVER)), is31fl3731)
         I2C_DRIVER_REQUIRED = yes
+        LED_PWM_BUFFER_REQUIRED = yes
         COMMON_VPATH += $(DRIVER_PATH)/led/issi
         SRC += is31fl3731.c
     endif
 
     ifeq ($(strip $(RGB_MATRIX_DRIVER)), is31fl3733)
         I2C_DRIVER_REQUIRED = yes
+        LED_PWM_BUFFER_REQUIRED = yes
         COMMON_VPATH += $(DRIVER_PATH)/led/issi
         SRC += is31fl3733.c
     endif
 
     ifeq ($(strip $(RGB_MATRIX_DRIVER)), is31fl3736)
         I2C_DRIVER_REQUIRED = yes
+        LED_PWM_BUFFER_REQUIRED = yes
         COMMON_VPATH += $(DRIVER_PATH)/led/issi
         SRC += is31fl3736.c
     endif
 
     ifeq ($(strip $(RGB_MATRIX_DRIVER)), is31fl3737)
         I2C_DRIVER_REQUIRED = yes
+        LED_PWM_BUFFER_REQUIRED = yes
         COMMON_VPATH += $(DRIVER_PATH)/led/issi
         SRC += is31fl3737.c
     endif
 
     ifeq ($(strip $(RGB_MATRIX_DRIVER)), is31fl3741)
         I2C_DRIVER_REQUIRED = yes
+        LED_PWM_BUFFER_REQUIRED = yes
         COMMON_VPATH += $(DRIVER_PATH)/led/issi
         SRC += is31fl3741.c
     endif
@@ -510,6 +565,7 @@ ifeq ($(strip $(RGB_MATRIX_ENABLE)), yes)
     ifeq ($(strip $(RGB_MATRIX_DRIVER)), is31fl3742a)
         OPT_DEFS += -DIS31FLCOMMON
         I2C_DRIVER_REQUIRED = yes
+        LED_PWM_BUFFER_REQUIRED = yes
         COMMON_VPATH += $(DRIVER_PATH)/led/issi
         SRC += is31flcommon.c
     endif
@@ -517,6 +573,7 @@ ifeq ($(strip $(RGB_MATRIX_ENABLE)), yes)
     ifeq ($(strip $(RGB_MATRIX_DRIVER)), is31fl3743a)
         OPT_DEFS += -DIS31FLCOMMON
         I2C_DRIVER_REQUIRED = yes
+        LED_PWM_BUFFER_REQUIRED = yes
         COMMON_VPATH += $(DRIVER_PATH)/led/issi
         SRC += is31flcommon.c
     endif
@@ -524,6 +581,7 @@ ifeq ($(strip $(RGB_MATRIX_ENABLE)), yes)
     ifeq ($(strip $(RGB_MATRIX_DRIVER)), is31fl3745)
         OPT_DEFS += -DIS31FLCOMMON
         I2C_DRIVER_REQUIRED = yes
+        LED_PWM_BUFFER_REQUIRED = yes
         COMMON_VPATH += $(DRIVER_PATH)/led/issi
         SRC += is31flcommon.c
     endif
@@ -531,18 +589,21 @@ ifeq ($(strip $(RGB_MATRIX_ENABLE)), yes)
     ifeq ($(strip $(RGB_MATRIX_DRIVER)), is31fl3746a)
         OPT_DEFS += -DIS31FLCOMMON
         I2C_DRIVER_REQUIRED = yes
+        LED_PWM_BUFFER_REQUIRED = yes
         COMMON_VPATH += $(DRIVER_PATH)/led/issi
         SRC += is31flcommon.c
     endif
 
     ifeq ($(strip $(RGB_MATRIX_DRIVER)), snled27351)
         I2C_DRIVER_REQUIRED = yes
+        LED_PWM_BUFFER_REQUIRED = yes
         COMMON_VPATH += $(DRIVER_PATH)/led
         SRC += snled27351.c
     endif
 
     ifeq ($(strip $(RGB_MATRIX_DRIVER)), snled27351_spi)
 	SPI_DRIVER_REQUIRED = yes
+        LED_PWM_BUFFER_REQUIRED = yes
         COMMON_VPATH += $(DRIVER_PATH)/led
         SRC += snled27351-spi.c
     endif
@@ -611,6 +672,11 @@ ifeq ($(strip $(BACKLIGHT_ENABLE)), yes)
     endif
 endif
 
+ifeq ($(strip $(LED_ENGINE_REQUIRED)), yes)
+    COMMON_VPATH += $(QUANTUM_DIR)/led_engine
+    SRC += $(QUANTUM_DIR)/led_engine/led_engine.c
+endif
+
 ifeq ($(strip $(CIE1931_CURVE)), yes)
     OPT_DEFS += -DUSE_CIE1931_CURVE
     LED_TABLES := yes
@@ -948,6 +1014,11 @@ ifeq ($(strip $(APA102_DRIVER_REQUIRED)), yes)
     SRC += apa102.c
 endif
 
+ifeq ($(strip $(LED_PWM_BUFFER_REQUIRED)), yes)
+    COMMON_VPATH += $(DRIVER_PATH)/led
+    SRC += led_pwm_buffer.c
+endif
+
 ifeq ($(strip $(ANALOG_DRIVER_REQUIRED)), yes)
     OPT_DEFS += -DHAL_USE_ADC=TRUE
     QUANTUM_LIB_SRC += analog.c
@@ -16,6 +16,7 @@
 #include "is31fl3218.h"
 #include <string.h>
 #include "i2c_master.h"
+#include "led_pwm_buffer.h"
 
 #define IS31FL3218_PWM_REGISTER_COUNT 18
 #define IS31FL3218_LED_CONTROL_REGISTER_COUNT 3
@@ -34,6 +35,9 @@ uint8_t g_twi_transfer_buffer[20];
 // IS31FL3218 has 18 PWM outputs and a fixed I2C address, so no chaining.
 uint8_t g_pwm_buffer[IS31FL3218_PWM_REGISTER_COUNT];
 bool    g_pwm_buffer_update_required = false;
+// One bit per PWM register, set when g_pwm_buffer holds a value not yet sent
+// to the chip, so flushes only rewrite the runs of registers that changed.
+uint8_t g_pwm_buffer_dirty[LED_PWM_DIRTY_SIZE(IS31FL3218_PWM_REGISTER_COUNT)] = {0};
 
 uint8_t g_led_control_registers[IS31FL3218_LED_CONTROL_REGISTER_COUNT] = {0};
 bool    g_led_control_registers_update_required                        = false;
@@ -50,17 +54,31 @@ void is31fl3218_write_register(uint8_t reg, uint8_t data) {
 #endif
 }
 
-void is31fl3218_write_pwm_buffer(uint8_t *pwm_buffer) {
-    g_twi_transfer_buffer[0] = IS31FL3218_REG_PWM;
-    memcpy(g_twi_transfer_buffer + 1, pwm_buffer, 18);
+static bool is31fl3218_write_pwm_run(uint8_t addr, uint8_t reg, uint8_t *data, uint8_t length) {
+    g_twi_transfer_buffer[0] = reg;
+    memcpy(g_twi_transfer_buffer + 1, data, length);
 
 #if IS31FL3218_I2C_PERSISTENCE > 0
     for (uint8_t i = 0; i < IS31FL3218_I2C_PERSISTENCE; i++) {
-        i2c_transmit(IS31FL3218_I2C_ADDRESS << 1, g_twi_transfer_buffer, 19, IS31FL3218_I2C_TIMEOUT);
+        i2c_transmit(addr << 1, g_twi_transfer_buffer, length + 1, IS31FL3218_I2C_TIMEOUT);
     }
 #else
-    i2c_transmit(IS31FL3218_I2C_ADDRESS << 1, g_twi_transfer_buffer, 19, IS31FL3218_I2C_TIMEOUT);
+    i2c_transmit(addr << 1, g_twi_transfer_buffer, length + 1, IS31FL3218_I2C_TIMEOUT);
 #endif
+    return true;
+}
+
+static const led_pwm_layout_t is31fl3218_pwm_layout = {
+    .count          = IS31FL3218_PWM_REGISTER_COUNT,
+    .page_size      = IS31FL3218_PWM_REGISTER_COUNT,
+    .first_register = IS31FL3218_REG_PWM,
+    .max_transfer   = IS31FL3218_PWM_REGISTER_COUNT,
+    .select_page    = NULL,
+    .write          = is31fl3218_write_pwm_run,
+};
+
+void is31fl3218_write_pwm_buffer(uint8_t *pwm_buffer) {
+    is31fl3218_write_pwm_run(IS31FL3218_I2C_ADDRESS, IS31FL3218_REG_PWM, pwm_buffer, IS31FL3218_PWM_REGISTER_COUNT);
 }
 
 void is31fl3218_init(void) {
@@ -97,13 +115,9 @@ void is31fl3218_set_color(int index, uint8_t red, uint8_t green, uint8_t blue) {
     if (index >= 0 && index < IS31FL3218_LED_COUNT) {
         memcpy_P(&led, (&g_is31fl3218_leds[index]), sizeof(led));
     }
-    if (g_pwm_buffer[led.r - IS31FL3218_REG_PWM] == red && g_pwm_buffer[led.g - IS31FL3218_REG_PWM] == green && g_pwm_buffer[led.b - IS31FL3218_REG_PWM] == blue) {
-        return;
+    if (led_pwm_buffer_set_rgb(g_pwm_buffer, g_pwm_buffer_dirty, led.r - IS31FL3218_REG_PWM, led.g - IS31FL3218_REG_PWM, led.b - IS31FL3218_REG_PWM, red, green, blue)) {
+        g_pwm_buffer_update_required = true;
     }
-    g_pwm_buffer[led.r - IS31FL3218_REG_PWM] = red;
-    g_pwm_buffer[led.g - IS31FL3218_REG_PWM] = green;
-    g_pwm_buffer[led.b - IS31FL3218_REG_PWM] = blue;
-    g_pwm_buffer_update_required             = true;
 }
 
 void is31fl3218_set_color_all(uint8_t red, uint8_t green, uint8_t blue) {
@@ -144,11 +158,10 @@ void is31fl3218_set_led_control_register(uint8_t index, bool red, bool green, bo
 
 void is31fl3218_update_pwm_buffers(void) {
     if (g_pwm_buffer_update_required) {
-        is31fl3218_write_pwm_buffer(g_pwm_buffer);
+        // Registers that failed to send stay dirty and are sent again on the next update
+        g_pwm_buffer_update_required = !led_pwm_buffer_flush(&is31fl3218_pwm_layout, IS31FL3218_I2C_ADDRESS, g_pwm_buffer, g_pwm_buffer_dirty);
         // Load PWM registers and LED Control register data
         is31fl3218_write_register(IS31FL3218_REG_UPDATE, 0x01);
-
-        g_pwm_buffer_update_required = false;
     }
 }
 
@@ -20,6 +20,7 @@
 #include <string.h>
 #include "i2c_master.h"
 #include "wait.h"
+#include "led_pwm_buffer.h"
 
 #define IS31FL3731_PWM_REGISTER_COUNT 144
 #define IS31FL3731_LED_CONTROL_REGISTER_COUNT 18
@@ -42,6 +43,9 @@ uint8_t g_twi_transfer_buffer[20];
 // probably not worth the extra complexity.
 uint8_t g_pwm_buffer[IS31FL3731_DRIVER_COUNT][IS31FL3731_PWM_REGISTER_COUNT];
 bool    g_pwm_buffer_update_required[IS31FL3731_DRIVER_COUNT] = {false};
+// One bit per PWM register, set when g_pwm_buffer holds a value not yet sent
+// to the chip, so flushes only rewrite the runs of registers that changed.
+uint8_t g_pwm_buffer_dirty[IS31FL3731_DRIVER_COUNT][LED_PWM_DIRTY_SIZE(IS31FL3731_PWM_REGISTER_COUNT)] = {0};
 
 uint8_t g_led_control_registers[IS31FL3731_DRIVER_COUNT][IS31FL3731_LED_CONTROL_REGISTER_COUNT] = {0};
 bool    g_led_control_registers_update_required[IS31FL3731_DRIVER_COUNT]                        = {false};
@@ -59,6 +63,33 @@ void is31fl3731_write_register(uint8_t addr, uint8_t reg, uint8_t data) {
 #endif
 }
 
+static bool is31fl3731_write_pwm_run(uint8_t addr, uint8_t reg, uint8_t *data, uint8_t length) {
+    // set the first register of the run
+    g_twi_transfer_buffer[0] = reg;
+    // device will auto-increment register for data after the first byte
+    // thus this sets up to 16 consecutive registers in one transfer
+    memcpy(g_twi_transfer_buffer + 1, data, length);
+
+#if IS31FL3731_I2C_PERSISTENCE > 0
+    for (uint8_t i = 0; i < IS31FL3731_I2C_PERSISTENCE; i++) {
+        if (i2c_transmit(addr << 1, g_twi_transfer_buffer, length + 1, IS31FL3731_I2C_TIMEOUT) == 0) break;
+    }
+#else
+    i2c_transmit(addr << 1, g_twi_transfer_buffer, length + 1, IS31FL3731_I2C_TIMEOUT);
+#endif
+    return true;
+}
+
+// PWM registers 0x24-0xB3 of frame 1, which is left selected after init.
+static const led_pwm_layout_t is31fl3731_pwm_layout = {
+    .count          = IS31FL3731_PWM_REGISTER_COUNT,
+    .page_size      = IS31FL3731_PWM_REGISTER_COUNT,
+    .first_register = 0x24,
+    .max_transfer   = 16,
+    .select_page    = NULL,
+    .write          = is31fl3731_write_pwm_run,
+};
+
 void is31fl3731_write_pwm_buffer(uint8_t addr, uint8_t *pwm_buffer) {
     // assumes bank is already selected
 
@@ -67,20 +98,7 @@ void is31fl3731_write_pwm_buffer(uint8_t addr, uint8_t *pwm_buffer) {
 
     // iterate over the pwm_buffer contents at 16 byte intervals
     for (int i = 0; i < IS31FL3731_PWM_REGISTER_COUNT; i += 16) {
-        // set the first register, e.g. 0x24, 0x34, 0x44, etc.
-        g_twi_transfer_buffer[0] = 0x24 + i;
-        // copy the data from i to i+15
-        // device will auto-increment register for data after the first byte
-        // thus this sets registers 0x24-0x33, 0x34-0x43, etc. in one transfer
-        memcpy(g_twi_transfer_buffer + 1, pwm_buffer + i, 16);
-
-#if IS31FL3731_I2C_PERSISTENCE > 0
-        for (uint8_t i = 0; i < IS31FL3731_I2C_PERSISTENCE; i++) {
-            if (i2c_transmit(addr << 1, g_twi_transfer_buffer, 17, IS31FL3731_I2C_TIMEOUT) == 0) break;
-        }
-#else
-        i2c_transmit(addr << 1, g_twi_transfer_buffer, 17, IS31FL3731_I2C_TIMEOUT);
-#endif
+        is31fl3731_write_pwm_run(addr, 0x24 + i, pwm_buffer + i, 16);
     }
 }
 
@@ -175,13 +193,9 @@ void is31fl3731_set_color(int index, uint8_t red, uint8_t green, uint8_t blue) {
         memcpy_P(&led, (&g_is31fl3731_leds[index]), sizeof(led));
 
         // Subtract 0x24 to get the second index of g_pwm_buffer
-        if (g_pwm_buffer[led.driver][led.r - 0x24] == red && g_pwm_buffer[led.driver][led.g - 0x24] == green && g_pwm_buffer[led.driver][led.b - 0x24] == blue) {
-            return;
+        if (led_pwm_buffer_set_rgb(g_pwm_buffer[led.driver], g_pwm_buffer_dirty[led.driver], led.r - 0x24, led.g - 0x24, led.b - 0x24, red, green, blue)) {
+            g_pwm_buffer_update_required[led.driver] = true;
         }
-        g_pwm_buffer[led.driver][led.r - 0x24]   = red;
-        g_pwm_buffer[led.driver][led.g - 0x24]   = green;
-        g_pwm_buffer[led.driver][led.b - 0x24]   = blue;
-        g_pwm_buffer_update_required[led.driver] = true;
     }
 }
 
@@ -223,9 +237,9 @@ void is31fl3731_set_led_control_register(uint8_t index, bool red, bool green, bo
 
 void is31fl3731_update_pwm_buffers(uint8_t addr, uint8_t index) {
     if (g_pwm_buffer_update_required[index]) {
-        is31fl3731_write_pwm_buffer(addr, g_pwm_buffer[index]);
+        // Registers that failed to send stay dirty and are sent again on the next update
+        g_pwm_buffer_update_required[index] = !led_pwm_buffer_flush(&is31fl3731_pwm_layout, addr, g_pwm_buffer[index], g_pwm_buffer_dirty[index]);
     }
-    g_pwm_buffer_update_required[index] = false;
 }
 
 void is31fl3731_update_led_control_registers(uint8_t addr, uint8_t index) {
@@ -22,6 +22,7 @@
 #include <string.h>
 #include "i2c_master.h"
 #include "wait.h"
+#include "led_pwm_buffer.h"
 
 #define IS31FL3733_PWM_REGISTER_COUNT 192
 #define IS31FL3733_LED_CONTROL_REGISTER_COUNT 24
@@ -74,6 +75,9 @@ uint8_t g_twi_transfer_buffer[20];
 // probably not worth the extra complexity.
 uint8_t g_pwm_buffer[IS31FL3733_DRIVER_COUNT][IS31FL3733_PWM_REGISTER_COUNT];
 bool    g_pwm_buffer_update_required[IS31FL3733_DRIVER_COUNT] = {false};
+// One bit per PWM register, set when g_pwm_buffer holds a value not yet sent
+// to the chip, so flushes only rewrite the runs of registers that changed.
+uint8_t g_pwm_buffer_dirty[IS31FL3733_DRIVER_COUNT][LED_PWM_DIRTY_SIZE(IS31FL3733_PWM_REGISTER_COUNT)] = {0};
 
 uint8_t g_led_control_registers[IS31FL3733_DRIVER_COUNT][IS31FL3733_LED_CONTROL_REGISTER_COUNT] = {0};
 bool    g_led_control_registers_update_required[IS31FL3733_DRIVER_COUNT]                        = {false};
@@ -97,31 +101,52 @@ bool is31fl3733_write_register(uint8_t addr, uint8_t reg, uint8_t data) {
     return true;
 }
 
+static bool is31fl3733_write_pwm_run(uint8_t addr, uint8_t reg, uint8_t *data, uint8_t length) {
+    // If the transaction fails function returns false.
+    g_twi_transfer_buffer[0] = reg;
+    // Device will auto-increment register for data after the first byte
+    // Thus this sets up to 16 consecutive registers in one transfer.
+    memcpy(g_twi_transfer_buffer + 1, data, length);
+
+#if IS31FL3733_I2C_PERSISTENCE > 0
+    for (uint8_t i = 0; i < IS31FL3733_I2C_PERSISTENCE; i++) {
+        if (i2c_transmit(addr << 1, g_twi_transfer_buffer, length + 1, IS31FL3733_I2C_TIMEOUT) != 0) {
+            return false;
+        }
+    }
+#else
+    if (i2c_transmit(addr << 1, g_twi_transfer_buffer, length + 1, IS31FL3733_I2C_TIMEOUT) != 0) {
+        return false;
+    }
+#endif
+    return true;
+}
+
+static bool is31fl3733_select_pwm_page(uint8_t addr, uint8_t page) {
+    // Unlock the command register and select PG1.
+    return is31fl3733_write_register(addr, IS31FL3733_REG_COMMAND_WRITE_LOCK, IS31FL3733_COMMAND_WRITE_LOCK_MAGIC) && is31fl3733_write_register(addr, IS31FL3733_REG_COMMAND, IS31FL3733_COMMAND_PWM);
+}
+
+// All PWM registers live on PG1.
+static const led_pwm_layout_t is31fl3733_pwm_layout = {
+    .count          = IS31FL3733_PWM_REGISTER_COUNT,
+    .page_size      = IS31FL3733_PWM_REGISTER_COUNT,
+    .first_register = 0x00,
+    .max_transfer   = 16,
+    .select_page    = is31fl3733_select_pwm_page,
+    .write          = is31fl3733_write_pwm_run,
+};
+
 bool is31fl3733_write_pwm_buffer(uint8_t addr, uint8_t *pwm_buffer) {
     // Assumes PG1 is already selected.
     // If any of the transactions fails function returns false.
     // Transmit PWM registers in 12 transfers of 16 bytes.
-    // g_twi_transfer_buffer[] is 20 bytes
 
     // Iterate over the pwm_buffer contents at 16 byte intervals.
     for (int i = 0; i < IS31FL3733_PWM_REGISTER_COUNT; i += 16) {
-        g_twi_transfer_buffer[0] = i;
-        // Copy the data from i to i+15.
-        // Device will auto-increment register for data after the first byte
-        // Thus this sets registers 0x00-0x0F, 0x10-0x1F, etc. in one transfer.
-        memcpy(g_twi_transfer_buffer + 1, pwm_buffer + i, 16);
-
-#if IS31FL3733_I2C_PERSISTENCE > 0
-        for (uint8_t i = 0; i < IS31FL3733_I2C_PERSISTENCE; i++) {
-            if (i2c_transmit(addr << 1, g_twi_transfer_buffer, 17, IS31FL3733_I2C_TIMEOUT) != 0) {
-                return false;
-            }
-        }
-#else
-        if (i2c_transmit(addr << 1, g_twi_transfer_buffer, 17, IS31FL3733_I2C_TIMEOUT) != 0) {
+        if (!is31fl3733_write_pwm_run(addr, i, pwm_buffer + i, 16)) {
             return false;
         }
-#endif
     }
     return true;
 }
@@ -207,11 +232,9 @@ void is31fl3733_set_value(int index, uint8_t value) {
     if (index >= 0 && index < IS31FL3733_LED_COUNT) {
         memcpy_P(&led, (&g_is31fl3733_leds[index]), sizeof(led));
 
-        if (g_pwm_buffer[led.driver][led.v] == value) {
-            return;
+        if (led_pwm_buffer_set(g_pwm_buffer[led.driver], g_pwm_buffer_dirty[led.driver], led.v, value)) {
+            g_pwm_buffer_update_required[led.driver] = true;
         }
-        g_pwm_buffer[led.driver][led.v]          = value;
-        g_pwm_buffer_update_required[led.driver] = true;
     }
 }
 
@@ -239,16 +262,13 @@ void is31fl3733_set_led_control_register(uint8_t index, bool value) {
 
 void is31fl3733_update_pwm_buffers(uint8_t addr, uint8_t index) {
     if (g_pwm_buffer_update_required[index]) {
-        // Firstly we need to unlock the command register and select PG1.
-        is31fl3733_write_register(addr, IS31FL3733_REG_COMMAND_WRITE_LOCK, IS31FL3733_COMMAND_WRITE_LOCK_MAGIC);
-        is31fl3733_write_register(addr, IS31FL3733_REG_COMMAND, IS31FL3733_COMMAND_PWM);
-
         // If any of the transactions fail we risk writing dirty PG0,
-        // refresh page 0 just in case.
-        if (!is31fl3733_write_pwm_buffer(addr, g_pwm_buffer[index])) {
+        // refresh page 0 just in case. The registers that failed stay
+        // dirty and are sent again on the next update.
+        g_pwm_buffer_update_required[index] = !led_pwm_buffer_flush(&is31fl3733_pwm_layout, addr, g_pwm_buffer[index], g_pwm_buffer_dirty[index]);
+        if (g_pwm_buffer_update_required[index]) {
             g_led_control_registers_update_required[index] = true;
         }
-        g_pwm_buffer_update_required[index] = false;
     }
 }
 
@@ -21,6 +21,7 @@
 #include <string.h>
 #include "i2c_master.h"
 #include "wait.h"
+#include "led_pwm_buffer.h"
 
 #define IS31FL3737_PWM_REGISTER_COUNT 192 // actually 144
 #define IS31FL3737_LED_CONTROL_REGISTER_COUNT 24
@@ -61,6 +62,9 @@ uint8_t g_twi_transfer_buffer[20];
 
 uint8_t g_pwm_buffer[IS31FL3737_DRIVER_COUNT][IS31FL3737_PWM_REGISTER_COUNT];
 bool    g_pwm_buffer_update_required[IS31FL3737_DRIVER_COUNT] = {false};
+// One bit per PWM register, set when g_pwm_buffer holds a value not yet sent
+// to the chip, so flushes only rewrite the runs of registers that changed.
+uint8_t g_pwm_buffer_dirty[IS31FL3737_DRIVER_COUNT][LED_PWM_DIRTY_SIZE(IS31FL3737_PWM_REGISTER_COUNT)] = {0};
 
 uint8_t g_led_control_registers[IS31FL3737_DRIVER_COUNT][IS31FL3737_LED_CONTROL_REGISTER_COUNT] = {0};
 bool    g_led_control_registers_update_required[IS31FL3737_DRIVER_COUNT]                        = {false};
@@ -78,27 +82,47 @@ void is31fl3737_write_register(uint8_t addr, uint8_t reg, uint8_t data) {
 #endif
 }
 
+static bool is31fl3737_write_pwm_run(uint8_t addr, uint8_t reg, uint8_t *data, uint8_t length) {
+    g_twi_transfer_buffer[0] = reg;
+    // device will auto-increment register for data after the first byte
+    // thus this sets up to 16 consecutive registers in one transfer
+    memcpy(g_twi_transfer_buffer + 1, data, length);
+
+#if IS31FL3737_I2C_PERSISTENCE > 0
+    for (uint8_t i = 0; i < IS31FL3737_I2C_PERSISTENCE; i++) {
+        if (i2c_transmit(addr << 1, g_twi_transfer_buffer, length + 1, IS31FL3737_I2C_TIMEOUT) == 0) break;
+    }
+#else
+    i2c_transmit(addr << 1, g_twi_transfer_buffer, length + 1, IS31FL3737_I2C_TIMEOUT);
+#endif
+    return true;
+}
+
+static bool is31fl3737_select_pwm_page(uint8_t addr, uint8_t page) {
+    // unlock the command register and select PG1
+    is31fl3737_write_register(addr, IS31FL3737_REG_COMMAND_WRITE_LOCK, IS31FL3737_COMMAND_WRITE_LOCK_MAGIC);
+    is31fl3737_write_register(addr, IS31FL3737_REG_COMMAND, IS31FL3737_COMMAND_PWM);
+    return true;
+}
+
+// All PWM registers live on PG1.
+static const led_pwm_layout_t is31fl3737_pwm_layout = {
+    .count          = IS31FL3737_PWM_REGISTER_COUNT,
+    .page_size      = IS31FL3737_PWM_REGISTER_COUNT,
+    .first_register = 0x00,
+    .max_transfer   = 16,
+    .select_page    = is31fl3737_select_pwm_page,
+    .write          = is31fl3737_write_pwm_run,
+};
+
 void is31fl3737_write_pwm_buffer(uint8_t addr, uint8_t *pwm_buffer) {
     // assumes PG1 is already selected
 
     // transmit PWM registers in 12 transfers of 16 bytes
-    // g_twi_transfer_buffer[] is 20 bytes
 
     // iterate over the pwm_buffer contents at 16 byte intervals
     for (int i = 0; i < IS31FL3737_PWM_REGISTER_COUNT; i += 16) {
-        g_twi_transfer_buffer[0] = i;
-        // copy the data from i to i+15
-        // device will auto-increment register for data after the first byte
-        // thus this sets registers 0x00-0x0F, 0x10-0x1F, etc. in one transfer
-        memcpy(g_twi_transfer_buffer + 1, pwm_buffer + i, 16);
-
-#if IS31FL3737_I2C_PERSISTENCE > 0
-        for (uint8_t i = 0; i < IS31FL3737_I2C_PERSISTENCE; i++) {
-            if (i2c_transmit(addr << 1, g_twi_transfer_buffer, 17, IS31FL3737_I2C_TIMEOUT) == 0) break;
-        }
-#else
-        i2c_transmit(addr << 1, g_twi_transfer_buffer, 17, IS31FL3737_I2C_TIMEOUT);
-#endif
+        is31fl3737_write_pwm_run(addr, i, pwm_buffer + i, 16);
     }
 }
 
@@ -182,11 +206,9 @@ void is31fl3737_set_value(int index, uint8_t value) {
     if (index >= 0 && index < IS31FL3737_LED_COUNT) {
         memcpy_P(&led, (&g_is31fl3737_leds[index]), sizeof(led));
 
-        if (g_pwm_buffer[led.driver][led.v] == value) {
-            return;
+        if (led_pwm_buffer_set(g_pwm_buffer[led.driver], g_pwm_buffer_dirty[led.driver], led.v, value)) {
+            g_pwm_buffer_update_required[led.driver] = true;
         }
-        g_pwm_buffer[led.driver][led.v]          = value;
-        g_pwm_buffer_update_required[led.driver] = true;
     }
 }
 
@@ -214,12 +236,8 @@ void is31fl3737_set_led_control_register(uint8_t index, bool value) {
 
 void is31fl3737_update_pwm_buffers(uint8_t addr, uint8_t index) {
     if (g_pwm_buffer_update_required[index]) {
-        // Firstly we need to unlock the command register and select PG1
-        is31fl3737_write_register(addr, IS31FL3737_REG_COMMAND_WRITE_LOCK, IS31FL3737_COMMAND_WRITE_LOCK_MAGIC);
-        is31fl3737_write_register(addr, IS31FL3737_REG_COMMAND, IS31FL3737_COMMAND_PWM);
-
-        is31fl3737_write_pwm_buffer(addr, g_pwm_buffer[index]);
-        g_pwm_buffer_update_required[index] = false;
+        // Registers that failed to send stay dirty and are sent again on the next update
+        g_pwm_buffer_update_required[index] = !led_pwm_buffer_flush(&is31fl3737_pwm_layout, addr, g_pwm_buffer[index], g_pwm_buffer_dirty[index]);
     }
 }
 
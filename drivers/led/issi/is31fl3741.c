@@ -21,6 +21,7 @@
 #include <string.h>
 #include "i2c_master.h"
 #include "wait.h"
+#include "led_pwm_buffer.h"
 
 #define IS31FL3741_PWM_REGISTER_COUNT 351
 
@@ -64,6 +65,9 @@ uint8_t g_twi_transfer_buffer[20] = {0xFF};
 uint8_t g_pwm_buffer[IS31FL3741_DRIVER_COUNT][IS31FL3741_PWM_REGISTER_COUNT];
 bool    g_pwm_buffer_update_required[IS31FL3741_DRIVER_COUNT]        = {false};
 bool    g_scaling_registers_update_required[IS31FL3741_DRIVER_COUNT] = {false};
+// One bit per PWM register, set when g_pwm_buffer holds a value not yet sent
+// to the chip, so flushes only rewrite the runs of registers that changed.
+uint8_t g_pwm_buffer_dirty[IS31FL3741_DRIVER_COUNT][LED_PWM_DIRTY_SIZE(IS31FL3741_PWM_REGISTER_COUNT)] = {0};
 
 uint8_t g_scaling_registers[IS31FL3741_DRIVER_COUNT][IS31FL3741_PWM_REGISTER_COUNT];
 
@@ -80,44 +84,18 @@ void is31fl3741_write_register(uint8_t addr, uint8_t reg, uint8_t data) {
 #endif
 }
 
-bool is31fl3741_write_pwm_buffer(uint8_t addr, uint8_t *pwm_buffer) {
-    // Assume PG0 is already selected
-
-    for (int i = 0; i < 342; i += 18) {
-        if (i == 180) {
-            // unlock the command register and select PG1
-            is31fl3741_write_register(addr, IS31FL3741_REG_COMMAND_WRITE_LOCK, IS31FL3741_COMMAND_WRITE_LOCK_MAGIC);
-            is31fl3741_write_register(addr, IS31FL3741_REG_COMMAND, IS31FL3741_COMMAND_PWM_1);
-        }
-
-        g_twi_transfer_buffer[0] = i % 180;
-        memcpy(g_twi_transfer_buffer + 1, pwm_buffer + i, 18);
-
-#if IS31FL3741_I2C_PERSISTENCE > 0
-        for (uint8_t i = 0; i < IS31FL3741_I2C_PERSISTENCE; i++) {
-            if (i2c_transmit(addr << 1, g_twi_transfer_buffer, 19, IS31FL3741_I2C_TIMEOUT) != 0) {
-                return false;
-            }
-        }
-#else
-        if (i2c_transmit(addr << 1, g_twi_transfer_buffer, 19, IS31FL3741_I2C_TIMEOUT) != 0) {
-            return false;
-        }
-#endif
-    }
-
-    // transfer the left cause the total number is 351
-    g_twi_transfer_buffer[0] = 162;
-    memcpy(g_twi_transfer_buffer + 1, pwm_buffer + 342, 9);
+static bool is31fl3741_write_pwm_run(uint8_t addr, uint8_t reg, uint8_t *data, uint8_t length) {
+    g_twi_transfer_buffer[0] = reg;
+    memcpy(g_twi_transfer_buffer + 1, data, length);
 
 #if IS31FL3741_I2C_PERSISTENCE > 0
     for (uint8_t i = 0; i < IS31FL3741_I2C_PERSISTENCE; i++) {
-        if (i2c_transmit(addr << 1, g_twi_transfer_buffer, 10, IS31FL3741_I2C_TIMEOUT) != 0) {
+        if (i2c_transmit(addr << 1, g_twi_transfer_buffer, length + 1, IS31FL3741_I2C_TIMEOUT) != 0) {
             return false;
         }
     }
 #else
-    if (i2c_transmit(addr << 1, g_twi_transfer_buffer, 10, IS31FL3741_I2C_TIMEOUT) != 0) {
+    if (i2c_transmit(addr << 1, g_twi_transfer_buffer, length + 1, IS31FL3741_I2C_TIMEOUT) != 0) {
         return false;
     }
 #endif
@@ -125,6 +103,40 @@ bool is31fl3741_write_pwm_buffer(uint8_t addr, uint8_t *pwm_buffer) {
     return true;
 }
 
+static bool is31fl3741_select_pwm_page(uint8_t addr, uint8_t page) {
+    // unlock the command register and select PG0 or PG1
+    is31fl3741_write_register(addr, IS31FL3741_REG_COMMAND_WRITE_LOCK, IS31FL3741_COMMAND_WRITE_LOCK_MAGIC);
+    is31fl3741_write_register(addr, IS31FL3741_REG_COMMAND, page == 0 ? IS31FL3741_COMMAND_PWM_0 : IS31FL3741_COMMAND_PWM_1);
+    return true;
+}
+
+// The first 180 PWM registers are on PG0, the remaining 171 on PG1.
+static const led_pwm_layout_t is31fl3741_pwm_layout = {
+    .count          = IS31FL3741_PWM_REGISTER_COUNT,
+    .page_size      = 180,
+    .first_register = 0x00,
+    .max_transfer   = 18,
+    .select_page    = is31fl3741_select_pwm_page,
+    .write          = is31fl3741_write_pwm_run,
+};
+
+bool is31fl3741_write_pwm_buffer(uint8_t addr, uint8_t *pwm_buffer) {
+    // Assume PG0 is already selected
+
+    for (int i = 0; i < 342; i += 18) {
+        if (i == 180) {
+            is31fl3741_select_pwm_page(addr, 1);
+        }
+
+        if (!is31fl3741_write_pwm_run(addr, i % 180, pwm_buffer + i, 18)) {
+            return false;
+        }
+    }
+
+    // transfer the left cause the total number is 351
+    return is31fl3741_write_pwm_run(addr, 162, pwm_buffer + 342, 9);
+}
+
 void is31fl3741_init_drivers(void) {
     i2c_init();
 
@@ -189,13 +201,9 @@ void is31fl3741_set_color(int index, uint8_t red, uint8_t green, uint8_t blue) {
     if (index >= 0 && index < IS31FL3741_LED_COUNT) {
         memcpy_P(&led, (&g_is31fl3741_leds[index]), sizeof(led));
 
-        if (g_pwm_buffer[led.driver][led.r] == red && g_pwm_buffer[led.driver][led.g] == green && g_pwm_buffer[led.driver][led.b] == blue) {
-            return;
+        if (led_pwm_buffer_set_rgb(g_pwm_buffer[led.driver], g_pwm_buffer_dirty[led.driver], led.r, led.g, led.b, red, green, blue)) {
+            g_pwm_buffer_update_required[led.driver] = true;
         }
-        g_pwm_buffer_update_required[led.driver] = true;
-        g_pwm_buffer[led.driver][led.r]          = red;
-        g_pwm_buffer[led.driver][led.g]          = green;
-        g_pwm_buffer[led.driver][led.b]          = blue;
     }
 }
 
@@ -232,22 +240,15 @@ void is31fl3741_set_led_control_register(uint8_t index, bool red, bool green, bo
 
 void is31fl3741_update_pwm_buffers(uint8_t addr, uint8_t index) {
     if (g_pwm_buffer_update_required[index]) {
-        // unlock the command register and select PG2
-        is31fl3741_write_register(addr, IS31FL3741_REG_COMMAND_WRITE_LOCK, IS31FL3741_COMMAND_WRITE_LOCK_MAGIC);
-        is31fl3741_write_register(addr, IS31FL3741_REG_COMMAND, IS31FL3741_COMMAND_PWM_0);
-
-        is31fl3741_write_pwm_buffer(addr, g_pwm_buffer[index]);
+        // Registers that failed to send stay dirty and are sent again on the next update
+        g_pwm_buffer_update_required[index] = !led_pwm_buffer_flush(&is31fl3741_pwm_layout, addr, g_pwm_buffer[index], g_pwm_buffer_dirty[index]);
     }
-
-    g_pwm_buffer_update_required[index] = false;
 }
 
 void is31fl3741_set_pwm_buffer(const is31fl3741_led_t *pled, uint8_t red, uint8_t green, uint8_t blue) {
-    g_pwm_buffer[pled->driver][pled->r] = red;
-    g_pwm_buffer[pled->driver][pled->g] = green;
-    g_pwm_buffer[pled->driver][pled->b] = blue;
-
-    g_pwm_buffer_update_required[pled->driver] = true;
+    if (led_pwm_buffer_set_rgb(g_pwm_buffer[pled->driver], g_pwm_buffer_dirty[pled->driver], pled->r, pled->g, pled->b, red, green, blue)) {
+        g_pwm_buffer_update_required[pled->driver] = true;
+    }
 }
 
 void is31fl3741_update_led_control_registers(uint8_t addr, uint8_t index) {
@@ -21,6 +21,7 @@
 #include "is31flcommon.h"
 #include "i2c_master.h"
 #include "wait.h"
+#include "led_pwm_buffer.h"
 #include <string.h>
 
 // Set defaults for Timeout and Persistence
@@ -38,6 +39,9 @@ uint8_t g_twi_transfer_buffer[20];
 // Storing them like this is optimal for I2C transfers to the registers.
 uint8_t g_pwm_buffer[DRIVER_COUNT][ISSI_MAX_LEDS];
 bool    g_pwm_buffer_update_required[DRIVER_COUNT] = {false};
+// One bit per PWM register, set when g_pwm_buffer holds a value not yet sent
+// to the chip, so flushes only rewrite the runs of registers that changed.
+uint8_t g_pwm_buffer_dirty[DRIVER_COUNT][LED_PWM_DIRTY_SIZE(ISSI_MAX_LEDS)] = {0};
 
 uint8_t g_scaling_buffer[DRIVER_COUNT][ISSI_SCALING_SIZE];
 bool    g_scaling_buffer_update_required[DRIVER_COUNT] = {false};
@@ -89,6 +93,24 @@ void IS31FL_unlock_register(uint8_t addr, uint8_t page) {
     IS31FL_write_single_register(addr, ISSI_COMMANDREGISTER, page);
 }
 
+static bool IS31FL_write_pwm_run(uint8_t addr, uint8_t reg, uint8_t *data, uint8_t length) {
+    return IS31FL_write_multi_registers(addr, data, length, length, reg);
+}
+
+static bool IS31FL_select_pwm_page(uint8_t addr, uint8_t page) {
+    IS31FL_unlock_register(addr, ISSI_PAGE_PWM);
+    return true;
+}
+
+static const led_pwm_layout_t IS31FL_pwm_layout = {
+    .count          = ISSI_MAX_LEDS,
+    .page_size      = ISSI_MAX_LEDS,
+    .first_register = ISSI_PWM_REG_1ST,
+    .max_transfer   = ISSI_PWM_TRF_SIZE,
+    .select_page    = IS31FL_select_pwm_page,
+    .write          = IS31FL_write_pwm_run,
+};
+
 void IS31FL_common_init(uint8_t addr, uint8_t ssr) {
     // Setup phase, need to take out of software shutdown and configure
     // ISSI_SSR_x is passed to allow Master / Slave setting where applicable
@@ -122,12 +144,9 @@ void IS31FL_common_init(uint8_t addr, uint8_t ssr) {
 
 void IS31FL_common_update_pwm_register(uint8_t addr, uint8_t index) {
     if (g_pwm_buffer_update_required[index]) {
-        // Queue up the correct page
-        IS31FL_unlock_register(addr, ISSI_PAGE_PWM);
-        // Hand off the update to IS31FL_write_multi_registers
-        IS31FL_write_multi_registers(addr, g_pwm_buffer[index], ISSI_MAX_LEDS, ISSI_PWM_TRF_SIZE, ISSI_PWM_REG_1ST);
-        // Update flags that pwm_buffer has been updated
-        g_pwm_buffer_update_required[index] = false;
+        // Queue up the correct page and send the runs of registers that changed
+        // Registers that failed to send stay dirty and are sent again on the next update
+        g_pwm_buffer_update_required[index] = !led_pwm_buffer_flush(&IS31FL_pwm_layout, addr, g_pwm_buffer[index], g_pwm_buffer_dirty[index]);
     }
 }
 
@@ -229,10 +248,9 @@ void IS31FL_RGB_set_color(int index, uint8_t red, uint8_t green, uint8_t blue) {
         is31_led led;
         memcpy_P(&led, (&g_is31_leds[index]), sizeof(led));
 
-        g_pwm_buffer[led.driver][led.r]          = red;
-        g_pwm_buffer[led.driver][led.g]          = green;
-        g_pwm_buffer[led.driver][led.b]          = blue;
-        g_pwm_buffer_update_required[led.driver] = true;
+        if (led_pwm_buffer_set_rgb(g_pwm_buffer[led.driver], g_pwm_buffer_dirty[led.driver], led.r, led.g, led.b, red, green, blue)) {
+            g_pwm_buffer_update_required[led.driver] = true;
+        }
     }
 }
 
@@ -317,8 +335,9 @@ void IS31FL_simple_set_brightness(int index, uint8_t value) {
         is31_led led;
         memcpy_P(&led, (&g_is31_leds[index]), sizeof(led));
 
-        g_pwm_buffer[led.driver][led.v] = value;
-        g_pwm_buffer_update_required[led.driver] = true;
+        if (led_pwm_buffer_set(g_pwm_buffer[led.driver], g_pwm_buffer_dirty[led.driver], led.v, value)) {
+            g_pwm_buffer_update_required[led.driver] = true;
+        }
     }
 }
 
@@ -0,0 +1,66 @@
+/* Copyright 2024 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "led_pwm_buffer.h"
+
+#define IS_DIRTY(dirty, i) ((dirty)[(i) / 8] & (1 << ((i) % 8)))
+
+bool led_pwm_buffer_flush(const led_pwm_layout_t *layout, uint8_t addr, uint8_t *buffer, uint8_t *dirty) {
+    uint16_t page_start = 0;
+    uint16_t selected   = UINT16_MAX;
+
+    for (uint16_t i = 0; i < layout->count; i++) {
+        if (i - page_start == layout->page_size) {
+            page_start = i;
+        }
+        if (!IS_DIRTY(dirty, i)) {
+            continue;
+        }
+
+        // grow the run until it fills a transfer, reaches the end of the page
+        // or meets a long enough stretch of clean registers
+        uint16_t limit = page_start + layout->page_size;
+        if (limit > layout->count) {
+            limit = layout->count;
+        }
+        if (limit > i + layout->max_transfer) {
+            limit = i + layout->max_transfer;
+        }
+        uint16_t end = i + 1;
+        for (uint16_t j = end; j < limit && j - end <= LED_PWM_RUN_GAP; j++) {
+            if (IS_DIRTY(dirty, j)) {
+                end = j + 1;
+            }
+        }
+
+        if (layout->select_page && selected != page_start) {
+            if (!layout->select_page(addr, page_start / layout->page_size)) {
+                return false;
+            }
+            selected = page_start;
+        }
+        if (!layout->write(addr, layout->first_register + (i - page_start), buffer + i, end - i)) {
+            return false;
+        }
+
+        for (uint16_t j = i; j < end; j++) {
+            dirty[j / 8] &= ~(1 << (j % 8));
+        }
+        i = end - 1;
+    }
+
+    return true;
+}
@@ -0,0 +1,83 @@
+/* Copyright 2024 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Clean registers between two dirty ones are rewritten rather than starting a
+// new transfer when the gap is at most this long, as each transfer costs at
+// least an address byte and a register byte on top of the data.
+#ifndef LED_PWM_RUN_GAP
+#    define LED_PWM_RUN_GAP 2
+#endif
+
+// Size of the dirty map needed for a buffer of `count` PWM registers.
+#define LED_PWM_DIRTY_SIZE(count) (((count) + 7) / 8)
+
+/**
+ * \brief Describes how a chip's PWM registers are laid out and written.
+ *
+ * Each IS31FL/SNLED27351 driver mirrors the PWM registers of its chips in a
+ * buffer, and fills one of these in so that led_pwm_buffer_flush() can send
+ * whatever changed in as few auto-increment transfers as possible.
+ */
+typedef struct {
+    uint16_t count;          // number of PWM registers in the buffer
+    uint16_t page_size;      // registers per page, transfers never cross a page boundary
+    uint8_t  first_register; // address of the first PWM register on each page
+    uint8_t  max_transfer;   // most registers the driver can write in one transfer
+
+    // Selects the given PWM page before it is written to, may be NULL if the
+    // page is already selected or the transport addresses pages itself.
+    bool (*select_page)(uint8_t addr, uint8_t page);
+    // Writes `length` consecutive registers, starting at `reg` on the current page.
+    bool (*write)(uint8_t addr, uint8_t reg, uint8_t *data, uint8_t length);
+} led_pwm_layout_t;
+
+/**
+ * \brief Update one PWM register in the buffer, marking it dirty if its value changed.
+ *
+ * \return true if the value changed
+ */
+static inline bool led_pwm_buffer_set(uint8_t *buffer, uint8_t *dirty, uint16_t offset, uint8_t value) {
+    if (buffer[offset] == value) {
+        return false;
+    }
+    buffer[offset] = value;
+    dirty[offset / 8] |= 1 << (offset % 8);
+    return true;
+}
+
+/**
+ * \brief Update the three PWM registers of an RGB LED, marking those that changed dirty.
+ *
+ * \return true if any value changed
+ */
+static inline bool led_pwm_buffer_set_rgb(uint8_t *buffer, uint8_t *dirty, uint16_t r, uint16_t g, uint16_t b, uint8_t red, uint8_t green, uint8_t blue) {
+    // bitwise or, so that every channel is updated
+    return led_pwm_buffer_set(buffer, dirty, r, red) | led_pwm_buffer_set(buffer, dirty, g, green) | led_pwm_buffer_set(buffer, dirty, b, blue);
+}
+
+/**
+ * \brief Write every dirty PWM register of one chip and mark them clean.
+ *
+ * Registers that failed to send stay dirty, so they are retried on the next flush.
+ *
+ * \return false if any transfer failed
+ */
+bool led_pwm_buffer_flush(const led_pwm_layout_t *layout, uint8_t addr, uint8_t *buffer, uint8_t *dirty);
@@ -16,6 +16,7 @@
 
 #include "snled27351-simple-spi.h"
 #include "spi_master.h"
+#include "led_pwm_buffer.h"
 
 #define SNLED27351_PWM_REGISTER_COUNT 192
 #define SNLED27351_LED_CONTROL_REGISTER_COUNT 24
@@ -48,6 +49,9 @@ error "no DRIVER_CS_PINS defined"
 // probably not worth the extra complexity.
 uint8_t g_pwm_buffer[SNLED27351_DRIVER_COUNT][SNLED27351_PWM_REGISTER_COUNT];
 bool    g_pwm_buffer_update_required[SNLED27351_DRIVER_COUNT] = {false};
+// One bit per PWM register, set when g_pwm_buffer holds a value not yet sent
+// to the chip, so flushes only rewrite the runs of registers that changed.
+uint8_t g_pwm_buffer_dirty[SNLED27351_DRIVER_COUNT][LED_PWM_DIRTY_SIZE(SNLED27351_PWM_REGISTER_COUNT)] = {0};
 
 uint8_t g_led_control_registers[SNLED27351_DRIVER_COUNT][SNLED27351_LED_CONTROL_REGISTER_COUNT]             = {0};
 bool    g_led_control_registers_update_required[SNLED27351_DRIVER_COUNT] = {false};
@@ -85,6 +89,20 @@ bool snled27351_write_register(uint8_t index, uint8_t page, uint8_t reg, uint8_t
     return snled27351_write(index, page, reg, &data, 1);
 }
 
+static bool snled27351_write_pwm_run(uint8_t index, uint8_t reg, uint8_t *data, uint8_t length) {
+    return snled27351_write(index, LED_PWM_PAGE, reg, data, length);
+}
+
+// The page is part of every SPI command, so there is nothing to select.
+static const led_pwm_layout_t snled27351_pwm_layout = {
+    .count          = SNLED27351_PWM_REGISTER_COUNT,
+    .page_size      = SNLED27351_PWM_REGISTER_COUNT,
+    .first_register = 0x00,
+    .max_transfer   = SNLED27351_PWM_REGISTER_COUNT,
+    .select_page    = NULL,
+    .write          = snled27351_write_pwm_run,
+};
+
 bool snled27351_write_pwm_buffer(uint8_t index, uint8_t *pwm_buffer) {
     if (g_pwm_buffer_update_required[index]) {
         snled27351_write(index, LED_PWM_PAGE, 0, g_pwm_buffer[index], SNLED27351_PWM_REGISTER_COUNT);
@@ -154,8 +172,9 @@ void snled27351_set_value(int index, uint8_t value) {
     if (index >= 0 && index < SNLED27351_LED_COUNT) {
         memcpy_P(&led, (&g_snled27351_leds[index]), sizeof(led));
 
-        g_pwm_buffer[led.driver][led.v]          = value;
-        g_pwm_buffer_update_required[led.driver] = true;
+        if (led_pwm_buffer_set(g_pwm_buffer[led.driver], g_pwm_buffer_dirty[led.driver], led.v, value)) {
+            g_pwm_buffer_update_required[led.driver] = true;
+        }
     }
 }
 
@@ -183,11 +202,12 @@ void snled27351_set_led_control_register(uint8_t index, bool value) {
 
 void snled27351_update_pwm_buffers(uint8_t index) {
     if (g_pwm_buffer_update_required[index]) {
-        if (!snled27351_write_pwm_buffer(index, g_pwm_buffer[index])) {
+        // Registers that failed to send stay dirty and are sent again on the next update
+        g_pwm_buffer_update_required[index] = !led_pwm_buffer_flush(&snled27351_pwm_layout, index, g_pwm_buffer[index], g_pwm_buffer_dirty[index]);
+        if (g_pwm_buffer_update_required[index]) {
             g_led_control_registers_update_required[index] = true;
         }
     }
-    g_pwm_buffer_update_required[index] = false;
 }
 
 void snled27351_update_led_control_registers(uint8_t index) {
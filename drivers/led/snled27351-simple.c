@@ -17,6 +17,7 @@
 #include "snled27351-simple.h"
 #include "i2c_master.h"
 #include "gpio.h"
+#include "led_pwm_buffer.h"
 
 #define SNLED27351_PWM_REGISTER_COUNT 192
 #define SNLED27351_LED_CONTROL_REGISTER_COUNT 24
@@ -49,6 +50,9 @@ uint8_t g_twi_transfer_buffer[20];
 // probably not worth the extra complexity.
 uint8_t g_pwm_buffer[SNLED27351_DRIVER_COUNT][SNLED27351_PWM_REGISTER_COUNT];
 bool    g_pwm_buffer_update_required[SNLED27351_DRIVER_COUNT] = {false};
+// One bit per PWM register, set when g_pwm_buffer holds a value not yet sent
+// to the chip, so flushes only rewrite the runs of registers that changed.
+uint8_t g_pwm_buffer_dirty[SNLED27351_DRIVER_COUNT][LED_PWM_DIRTY_SIZE(SNLED27351_PWM_REGISTER_COUNT)] = {0};
 
 uint8_t g_led_control_registers[SNLED27351_DRIVER_COUNT][SNLED27351_LED_CONTROL_REGISTER_COUNT] = {0};
 bool    g_led_control_registers_update_required[SNLED27351_DRIVER_COUNT]                        = {false};
@@ -72,33 +76,53 @@ bool snled27351_write_register(uint8_t addr, uint8_t reg, uint8_t data) {
     return true;
 }
 
+static bool snled27351_write_pwm_run(uint8_t addr, uint8_t reg, uint8_t *data, uint8_t length) {
+    // If the transaction fails function returns false.
+    g_twi_transfer_buffer[0] = reg;
+    // Device will auto-increment register for data after the first byte
+    // Thus this sets up to 16 consecutive registers in one transfer.
+    for (uint8_t i = 0; i < length; i++) {
+        g_twi_transfer_buffer[1 + i] = data[i];
+    }
+
+#if SNLED27351_I2C_PERSISTENCE > 0
+    for (uint8_t i = 0; i < SNLED27351_I2C_PERSISTENCE; i++) {
+        if (i2c_transmit(addr << 1, g_twi_transfer_buffer, length + 1, SNLED27351_I2C_TIMEOUT) != 0) {
+            return false;
+        }
+    }
+#else
+    if (i2c_transmit(addr << 1, g_twi_transfer_buffer, length + 1, SNLED27351_I2C_TIMEOUT) != 0) {
+        return false;
+    }
+#endif
+    return true;
+}
+
+static bool snled27351_select_pwm_page(uint8_t addr, uint8_t page) {
+    return snled27351_write_register(addr, SNLED27351_REG_COMMAND, SNLED27351_COMMAND_PWM);
+}
+
+// All PWM registers live on PG1.
+static const led_pwm_layout_t snled27351_pwm_layout = {
+    .count          = SNLED27351_PWM_REGISTER_COUNT,
+    .page_size      = SNLED27351_PWM_REGISTER_COUNT,
+    .first_register = 0x00,
+    .max_transfer   = 16,
+    .select_page    = snled27351_select_pwm_page,
+    .write          = snled27351_write_pwm_run,
+};
+
 bool snled27351_write_pwm_buffer(uint8_t addr, uint8_t *pwm_buffer) {
     // Assumes PG1 is already selected.
     // If any of the transactions fails function returns false.
     // Transmit PWM registers in 12 transfers of 16 bytes.
-    // g_twi_transfer_buffer[] is 20 bytes
 
     // Iterate over the pwm_buffer contents at 16 byte intervals.
     for (int i = 0; i < SNLED27351_PWM_REGISTER_COUNT; i += 16) {
-        g_twi_transfer_buffer[0] = i;
-        // Copy the data from i to i+15.
-        // Device will auto-increment register for data after the first byte
-        // Thus this sets registers 0x00-0x0F, 0x10-0x1F, etc. in one transfer.
-        for (int j = 0; j < 16; j++) {
-            g_twi_transfer_buffer[1 + j] = pwm_buffer[i + j];
-        }
-
-#if SNLED27351_I2C_PERSISTENCE > 0
-        for (uint8_t i = 0; i < SNLED27351_I2C_PERSISTENCE; i++) {
-            if (i2c_transmit(addr << 1, g_twi_transfer_buffer, 17, SNLED27351_I2C_TIMEOUT) != 0) {
-                return false;
-            }
-        }
-#else
-        if (i2c_transmit(addr << 1, g_twi_transfer_buffer, 17, SNLED27351_I2C_TIMEOUT) != 0) {
+        if (!snled27351_write_pwm_run(addr, i, pwm_buffer + i, 16)) {
             return false;
         }
-#endif
     }
     return true;
 }
@@ -184,11 +208,9 @@ void snled27351_set_value(int index, uint8_t value) {
     if (index >= 0 && index < SNLED27351_LED_COUNT) {
         memcpy_P(&led, (&g_snled27351_leds[index]), sizeof(led));
 
-        if (g_pwm_buffer[led.driver][led.v] == value) {
-            return;
+        if (led_pwm_buffer_set(g_pwm_buffer[led.driver], g_pwm_buffer_dirty[led.driver], led.v, value)) {
+            g_pwm_buffer_update_required[led.driver] = true;
         }
-        g_pwm_buffer[led.driver][led.v]          = value;
-        g_pwm_buffer_update_required[led.driver] = true;
     }
 }
 
@@ -216,15 +238,14 @@ void snled27351_set_led_control_register(uint8_t index, bool value) {
 
 void snled27351_update_pwm_buffers(uint8_t addr, uint8_t index) {
     if (g_pwm_buffer_update_required[index]) {
-        snled27351_write_register(addr, SNLED27351_REG_COMMAND, SNLED27351_COMMAND_PWM);
-
         // If any of the transactions fail we risk writing dirty PG0,
-        // refresh page 0 just in case.
-        if (!snled27351_write_pwm_buffer(addr, g_pwm_buffer[index])) {
+        // refresh page 0 just in case. The registers that failed stay
+        // dirty and are sent again on the next update.
+        g_pwm_buffer_update_required[index] = !led_pwm_buffer_flush(&snled27351_pwm_layout, addr, g_pwm_buffer[index], g_pwm_buffer_dirty[index]);
+        if (g_pwm_buffer_update_required[index]) {
             g_led_control_registers_update_required[index] = true;
         }
     }
-    g_pwm_buffer_update_required[index] = false;
 }
 
 void snled27351_update_led_control_registers(uint8_t addr, uint8_t index) {
@@ -0,0 +1,23 @@
+// Copyright 2023 QMK
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "i2c_mock.hpp"
+
+extern "C" {
+#include "i2c_master.h"
+}
+
+std::vector<I2cTransfer> i2c_transfers;
+int                      i2c_failing_runs = 0;
+
+void i2c_init(void) {}
+
+i2c_status_t i2c_transmit(uint8_t address, const uint8_t *data, uint16_t length, uint16_t timeout) {
+    i2c_transfers.push_back({address, std::vector<uint8_t>(data, data + length)});
+    // Register writes are two bytes, anything longer is a run of PWM registers
+    if (length > 2 && i2c_failing_runs > 0) {
+        i2c_failing_runs--;
+        return I2C_STATUS_ERROR;
+    }
+    return I2C_STATUS_SUCCESS;
+}
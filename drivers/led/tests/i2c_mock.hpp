@@ -0,0 +1,16 @@
+// Copyright 2023 QMK
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+struct I2cTransfer {
+    uint8_t              address;
+    std::vector<uint8_t> data;
+};
+
+/* Every transfer sent through i2c_transmit(), including the failed ones. */
+extern std::vector<I2cTransfer> i2c_transfers;
+/* Number of upcoming multi-byte register writes that should fail. */
+extern int i2c_failing_runs;
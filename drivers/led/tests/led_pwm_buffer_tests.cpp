@@ -0,0 +1,65 @@
+// Copyright 2023 QMK
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "gtest/gtest.h"
+#include "i2c_mock.hpp"
+
+extern "C" {
+#include "is31fl3733.h"
+}
+
+#define ADDR 0x50
+
+// Far enough apart that each LED is sent in its own run
+const is31fl3733_led_t PROGMEM g_is31fl3733_leds[IS31FL3733_LED_COUNT] = {
+    {0, 0x00, 0x01, 0x02},
+    {0, 0x80, 0x81, 0x82},
+};
+
+class LedPwmBuffer : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        is31fl3733_set_color_all(0, 0, 0);
+        is31fl3733_update_pwm_buffers(ADDR, 0);
+        i2c_failing_runs = 0;
+        i2c_transfers.clear();
+    }
+
+    // Returns the runs of PWM registers sent since the last call
+    std::vector<std::vector<uint8_t>> sent_runs() {
+        std::vector<std::vector<uint8_t>> runs;
+        for (auto &transfer : i2c_transfers) {
+            EXPECT_EQ(transfer.address, ADDR << 1);
+            if (transfer.data.size() > 2) {
+                runs.push_back(transfer.data);
+            }
+        }
+        i2c_transfers.clear();
+        return runs;
+    }
+};
+
+TEST_F(LedPwmBuffer, OnlyChangedRunsAreSent) {
+    is31fl3733_set_color(1, 4, 5, 6);
+    is31fl3733_update_pwm_buffers(ADDR, 0);
+    EXPECT_EQ(sent_runs(), (std::vector<std::vector<uint8_t>>{{0x80, 4, 5, 6}}));
+
+    is31fl3733_update_pwm_buffers(ADDR, 0);
+    EXPECT_TRUE(sent_runs().empty());
+}
+
+TEST_F(LedPwmBuffer, FailedRunIsSentAgainOnNextUpdate) {
+    is31fl3733_set_color(0, 1, 2, 3);
+    is31fl3733_set_color(1, 4, 5, 6);
+
+    i2c_failing_runs = 1;
+    is31fl3733_update_pwm_buffers(ADDR, 0);
+    EXPECT_EQ(sent_runs(), (std::vector<std::vector<uint8_t>>{{0x00, 1, 2, 3}}));
+
+    // Nothing else changed, the update still has to retry the failed run and send the rest
+    is31fl3733_update_pwm_buffers(ADDR, 0);
+    EXPECT_EQ(sent_runs(), (std::vector<std::vector<uint8_t>>{{0x00, 1, 2, 3}, {0x80, 4, 5, 6}}));
+
+    is31fl3733_update_pwm_buffers(ADDR, 0);
+    EXPECT_TRUE(sent_runs().empty());
+}
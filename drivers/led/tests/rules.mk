@@ -0,0 +1,12 @@
+led_pwm_buffer_DEFS := -DIS31FL3733_I2C_ADDRESS_1=0x50 -DIS31FL3733_LED_COUNT=2
+led_pwm_buffer_INC := \
+	$(DRIVER_PATH)/led/tests \
+	$(DRIVER_PATH)/led \
+	$(DRIVER_PATH)/led/issi
+
+led_pwm_buffer_SRC := \
+	platforms/test/timer.c \
+	$(DRIVER_PATH)/led/tests/i2c_mock.cpp \
+	$(DRIVER_PATH)/led/tests/led_pwm_buffer_tests.cpp \
+	$(DRIVER_PATH)/led/issi/is31fl3733.c \
+	$(DRIVER_PATH)/led/led_pwm_buffer.c
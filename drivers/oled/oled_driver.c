@@ -387,10 +387,11 @@ void oled_clear(void) {
     oled_dirty  = OLED_ALL_BLOCKS_MASK;
 }
 
-static void calc_bounds(uint8_t update_start, uint8_t *cmd_array) {
+static void calc_bounds(uint8_t update_start, uint8_t update_count, uint8_t *cmd_array) {
     // Calculate commands to set memory addressing bounds.
-    uint8_t start_page   = OLED_BLOCK_SIZE * update_start / OLED_DISPLAY_WIDTH;
-    uint8_t start_column = OLED_BLOCK_SIZE * update_start % OLED_DISPLAY_WIDTH;
+    uint16_t update_size  = OLED_BLOCK_SIZE * update_count;
+    uint8_t  start_page   = OLED_BLOCK_SIZE * update_start / OLED_DISPLAY_WIDTH;
+    uint8_t  start_column = OLED_BLOCK_SIZE * update_start % OLED_DISPLAY_WIDTH;
 #if !OLED_IC_HAS_HORIZONTAL_MODE
     // Commands for Page Addressing Mode. Sets starting page and column; has no end bound.
     // Column value must be split into high and low nybble and sent as two commands.
@@ -401,8 +402,8 @@ static void calc_bounds(uint8_t update_start, uint8_t *cmd_array) {
     // Commands for use in Horizontal Addressing mode.
     cmd_array[1] = start_column + OLED_COLUMN_OFFSET;
     cmd_array[4] = start_page;
-    cmd_array[2] = (OLED_BLOCK_SIZE + OLED_DISPLAY_WIDTH - 1) % OLED_DISPLAY_WIDTH + cmd_array[1];
-    cmd_array[5] = (OLED_BLOCK_SIZE + OLED_DISPLAY_WIDTH - 1) / OLED_DISPLAY_WIDTH - 1 + cmd_array[4];
+    cmd_array[2] = (update_size < OLED_DISPLAY_WIDTH ? update_size : OLED_DISPLAY_WIDTH) - 1 + cmd_array[1];
+    cmd_array[5] = (update_size + OLED_DISPLAY_WIDTH - 1) / OLED_DISPLAY_WIDTH - 1 + cmd_array[4];
 #endif
 }
 
@@ -436,19 +437,59 @@ static void calc_bounds_90(uint8_t update_start, uint8_t *cmd_array) {
 #endif
 }
 
-uint8_t crot(uint8_t a, int8_t n) {
-    const uint8_t mask = 0x7;
-    n &= mask;
-    return a << n | a >> (-n & mask);
+// Rotates an 8x8 pixel tile: bit i of src[j] becomes bit 7 - j of dest[i].
+// The tile is transposed as two 32-bit words by swapping 1x1, 2x2 and then
+// 4x4 sub-blocks across the diagonal, instead of moving it one bit at a time.
+static void rotate_90(const uint8_t *src, uint8_t *dest) {
+    uint32_t x = ((uint32_t)src[0] << 24) | ((uint32_t)src[1] << 16) | ((uint32_t)src[2] << 8) | src[3];
+    uint32_t y = ((uint32_t)src[4] << 24) | ((uint32_t)src[5] << 16) | ((uint32_t)src[6] << 8) | src[7];
+    uint32_t t;
+
+    t = (x ^ (x >> 7)) & 0x00AA00AA;
+    x = x ^ t ^ (t << 7);
+    t = (y ^ (y >> 7)) & 0x00AA00AA;
+    y = y ^ t ^ (t << 7);
+
+    t = (x ^ (x >> 14)) & 0x0000CCCC;
+    x = x ^ t ^ (t << 14);
+    t = (y ^ (y >> 14)) & 0x0000CCCC;
+    y = y ^ t ^ (t << 14);
+
+    t = (x & 0xF0F0F0F0) | ((y >> 4) & 0x0F0F0F0F);
+    y = ((x << 4) & 0xF0F0F0F0) | (y & 0x0F0F0F0F);
+    x = t;
+
+    dest[0] |= y;
+    dest[1] |= y >> 8;
+    dest[2] |= y >> 16;
+    dest[3] |= y >> 24;
+    dest[4] |= x;
+    dest[5] |= x >> 8;
+    dest[6] |= x >> 16;
+    dest[7] |= x >> 24;
 }
 
-static void rotate_90(const uint8_t *src, uint8_t *dest) {
-    for (uint8_t i = 0, shift = 7; i < 8; ++i, --shift) {
-        uint8_t selector = (1 << i);
-        for (uint8_t j = 0; j < 8; ++j) {
-            dest[i] |= crot(src[j] & selector, shift - (int8_t)j);
-        }
+// Counts the dirty blocks from update_start on, up to limit, that can be sent
+// in a single transfer. The controller's column window is set once for the
+// whole run, so it has to stay on one page unless horizontal addressing can
+// wrap it over whole pages.
+static uint8_t calc_run_length(uint8_t update_start, uint8_t limit) {
+    uint8_t update_count = 1;
+    while (update_count < limit && update_start + update_count < OLED_BLOCK_COUNT && (oled_dirty & ((OLED_BLOCK_TYPE)1 << (update_start + update_count)))) {
+        ++update_count;
     }
+
+    uint16_t start_column = OLED_BLOCK_SIZE * update_start % OLED_DISPLAY_WIDTH;
+#if OLED_IC_HAS_HORIZONTAL_MODE
+    if (start_column == 0) {
+        return update_count;
+    }
+#endif
+    uint8_t page_blocks = (OLED_DISPLAY_WIDTH - start_column) / OLED_BLOCK_SIZE;
+    if (update_count > page_blocks) {
+        update_count = page_blocks ? page_blocks : 1;
+    }
+    return update_count;
 }
 
 void oled_render_dirty(bool all) {
@@ -463,11 +504,12 @@ void oled_render_dirty(bool all) {
 
     uint8_t update_start  = 0;
     uint8_t num_processed = 0;
-    while (oled_dirty && (num_processed++ < OLED_UPDATE_PROCESS_LIMIT || all)) { // render all dirty blocks (up to the configured limit)
+    while (oled_dirty && (num_processed < OLED_UPDATE_PROCESS_LIMIT || all)) { // render all dirty blocks (up to the configured limit)
         // Find next dirty block
         while (!(oled_dirty & ((OLED_BLOCK_TYPE)1 << update_start))) {
             ++update_start;
         }
+        uint8_t update_count = 1;
 
         // Set column & page position
 #if OLED_IC_HAS_HORIZONTAL_MODE
@@ -476,7 +518,9 @@ void oled_render_dirty(bool all) {
         static uint8_t display_start[] = {I2C_CMD, PAM_PAGE_ADDR, PAM_SETCOLUMN_LSB, PAM_SETCOLUMN_MSB};
 #endif
         if (!HAS_FLAGS(oled_rotation, OLED_ROTATION_90)) {
-            calc_bounds(update_start, &display_start[1]); // Offset from I2C_CMD byte at the start
+            // Neighbouring dirty blocks are sent together, saving a command and a transfer per block
+            update_count = calc_run_length(update_start, all ? OLED_BLOCK_COUNT : OLED_UPDATE_PROCESS_LIMIT - num_processed);
+            calc_bounds(update_start, update_count, &display_start[1]); // Offset from I2C_CMD byte at the start
         } else {
             calc_bounds_90(update_start, &display_start[1]); // Offset from I2C_CMD byte at the start
         }
@@ -489,7 +533,7 @@ void oled_render_dirty(bool all) {
 
         if (!HAS_FLAGS(oled_rotation, OLED_ROTATION_90)) {
             // Send render data chunk as is
-            if (!oled_send_data(&oled_buffer[OLED_BLOCK_SIZE * update_start], OLED_BLOCK_SIZE)) {
+            if (!oled_send_data(&oled_buffer[OLED_BLOCK_SIZE * update_start], OLED_BLOCK_SIZE * update_count)) {
                 print("oled_render data failed\n");
                 return;
             }
@@ -532,8 +576,10 @@ void oled_render_dirty(bool all) {
 #endif
         }
 
-        // Clear dirty flag of just rendered block
-        oled_dirty &= ~((OLED_BLOCK_TYPE)1 << update_start);
+        // Clear dirty flags of just rendered blocks
+        for (; update_count > 0; --update_count, ++update_start, ++num_processed) {
+            oled_dirty &= ~((OLED_BLOCK_TYPE)1 << update_start);
+        }
     }
 }
 
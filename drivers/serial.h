@@ -28,6 +28,18 @@ void soft_serial_target_init(void);
 
 bool soft_serial_transaction(int sstd_index);
 
+typedef struct {
+    uint32_t transactions;  // transactions started (master) or answered (slave)
+    uint32_t errors;        // failed transactions, each of which the master retries
+    uint16_t fallbacks;     // times the link dropped back to its base speed
+    uint16_t round_trip_us; // duration of the last successful transaction, master only
+    uint8_t  speed_step;    // current baudrate, as doublings of the base speed
+} serial_link_stats_t;
+
+// link quality counters, the bitbang drivers only count the initiator's
+// transactions and errors
+const serial_link_stats_t *serial_link_get_stats(void);
+
 #ifdef SERIAL_DEBUG
 #    include <debug.h>
 #    include <print.h>
@@ -0,0 +1,203 @@
+"""Decode the deferred trace records sent by tprintf().
+
+Trace records only carry the address of their format string, which is looked up in the firmware's .elf file.
+"""
+import re
+import struct
+import sys
+from pathlib import Path
+
+from argcomplete.completers import FilesCompleter
+from milc import cli
+
+import qmk.path
+
+CONSOLE_USAGE_PAGE = 0xFF31
+CONSOLE_USAGE = 0x0074
+
+FRAME_START = 0x1E
+FRAME_END = 0x00
+
+SHF_ALLOC = 0x2
+SHT_NOBITS = 8
+EM_AVR = 83
+
+FORMAT_RE = re.compile(r'%([-+ #0]*)(\d*)(?:\.(\d+))?(?:hh|h|ll|l|z)?([diuxXcob%])')
+
+
+class FirmwareImage:
+    """The loaded sections of a 32 bit .elf file.
+    """
+    def __init__(self, path):
+        data = Path(path).read_bytes()
+        if data[:4] != b'\x7fELF' or data[4] != 1:
+            raise ValueError(f'{path} is not a 32 bit ELF file')
+
+        endian = '<' if data[5] == 1 else '>'
+        machine, = struct.unpack_from(endian + 'H', data, 18)
+        section_offset, = struct.unpack_from(endian + 'I', data, 32)
+        section_size, section_count = struct.unpack_from(endian + 'HH', data, 46)
+
+        self.endian = endian
+        self.id_size = 2 if machine == EM_AVR else 4
+        self.data = data
+        self.sections = []
+
+        for index in range(section_count):
+            _, section_type, flags, address, offset, size = struct.unpack_from(endian + 'IIIIII', data, section_offset + index * section_size)
+            if flags & SHF_ALLOC and section_type != SHT_NOBITS and size:
+                self.sections.append((address, offset, size))
+
+    def string(self, address):
+        """Returns the zero terminated string at `address`, or None if it is not in the image.
+        """
+        for start, offset, size in self.sections:
+            if start <= address < start + size:
+                begin = offset + address - start
+                end = self.data.find(b'\0', begin, offset + size)
+                if end < 0:
+                    return None
+                return self.data[begin:end].decode('utf-8', errors='replace')
+        return None
+
+
+def format_record(fmt, args):
+    """Formats the 32 bit `args` with a printf style `fmt`.
+    """
+    args = list(args)
+
+    def convert(match):
+        flags, width, precision, conversion = match.groups()
+        if conversion == '%':
+            return '%'
+        if not args:
+            return match.group(0)
+
+        value = args.pop(0)
+        if conversion == 'b':
+            text = format(value, 'b')
+            fill = '0' if '0' in flags else ' '
+            return text.ljust(int(width or 0)) if '-' in flags else text.rjust(int(width or 0), fill)
+        if conversion in 'di':
+            value -= (value & 0x80000000) << 1
+        if conversion == 'c':
+            value = value & 0xFF
+        spec = '%' + flags + width + ('.' + precision if precision else '') + conversion.replace('i', 'd')
+        return spec % value
+
+    return FORMAT_RE.sub(convert, fmt)
+
+
+class TraceDecoder:
+    """Splits the console byte stream into text lines and decoded trace records.
+    """
+    def __init__(self, image):
+        self.image = image
+        self.frame = None
+        self.text = bytearray()
+        self.last_time = None
+        self.time = 0
+
+    def feed(self, data):
+        """Consumes `data`, returning any complete lines.
+        """
+        lines = []
+        for byte in data:
+            if self.frame is not None:
+                if byte == FRAME_END:
+                    lines.append(self._decode(self.frame))
+                    self.frame = None
+                else:
+                    self.frame.append(byte)
+            elif byte == FRAME_START:
+                self.frame = bytearray()
+            elif byte == ord('\n'):
+                lines.append(self.text.decode('utf-8', errors='replace').rstrip('\r'))
+                self.text.clear()
+            elif byte != 0:
+                # Zero bytes are padding in fixed size reports
+                self.text.append(byte)
+        return lines
+
+    def _decode(self, frame):
+        record = cobs_decode(frame)
+        header = self.image.id_size + 2
+        if record is None or len(record) < header or (len(record) - header) % 4:
+            return '<corrupted trace record>'
+
+        id_format = self.image.endian + {2: 'H', 4: 'I', 8: 'Q'}[self.image.id_size]
+        address, = struct.unpack_from(id_format, record)
+        time, = struct.unpack_from(self.image.endian + 'H', record, self.image.id_size)
+        args = struct.unpack_from(self.image.endian + 'I' * ((len(record) - header) // 4), record, header)
+
+        # Timestamps are the low 16 bits of the firmware's millisecond timer
+        if self.last_time is not None:
+            self.time += (time - self.last_time) & 0xFFFF
+        self.last_time = time
+        stamp = f'[{self.time / 1000:10.3f}]'
+
+        if address == 0:
+            return f'{stamp} <{args[0] if args else 0} trace records dropped>'
+
+        fmt = self.image.string(address)
+        if fmt is None:
+            return f'{stamp} <unknown trace format 0x{address:x}> {" ".join(f"0x{arg:x}" for arg in args)}'
+        return stamp + ' ' + format_record(fmt, args).rstrip('\r\n')
+
+
+def cobs_decode(frame):
+    """Undoes the COBS encoding of a frame, returning None if it is malformed.
+    """
+    record = bytearray()
+    index = 0
+    while index < len(frame):
+        code = frame[index]
+        if code == 0 or index + code > len(frame):
+            return None
+        record += frame[index + 1:index + code]
+        index += code
+        if code < 0xFF and index < len(frame):
+            record.append(0)
+    return bytes(record)
+
+
+def _read_console():
+    """Yields the reports of the first console found.
+    """
+    import hid
+
+    for device in hid.enumerate():
+        if device['usage_page'] == CONSOLE_USAGE_PAGE and device['usage'] == CONSOLE_USAGE:
+            cli.log.info('Listening to %s %s', device['manufacturer_string'], device['product_string'])
+            console = hid.Device(path=device['path'])
+            while True:
+                yield console.read(64)
+
+    cli.log.error('No console device found.')
+
+
+@cli.argument('-i', '--input', arg_only=True, type=qmk.path.normpath, help='Console capture to decode instead of listening to the keyboard. Use "-" for stdin.')
+@cli.argument('elf', arg_only=True, type=qmk.path.normpath, completer=FilesCompleter('.elf'), help='The .elf file of the running firmware.')
+@cli.subcommand('Decodes deferred trace records from the console.')
+def console_trace(cli):
+    """Prints the console output of a keyboard, formatting tprintf() records with the strings in its .elf file.
+    """
+    try:
+        decoder = TraceDecoder(FirmwareImage(cli.args.elf))
+    except (OSError, ValueError) as e:
+        cli.log.error('Unable to load firmware image: %s', e)
+        return False
+
+    if cli.args.input:
+        capture = sys.stdin.buffer if cli.args.input.name == '-' else cli.args.input.open('rb')
+        source = iter(lambda: capture.read(64), b'')
+    else:
+        source = _read_console()
+
+    try:
+        for data in source:
+            for line in decoder.feed(data):
+                print(line)
+            sys.stdout.flush()
+    except KeyboardInterrupt:
+        pass
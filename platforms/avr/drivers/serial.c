@@ -437,7 +437,7 @@ ISR(SERIAL_PIN_INTERRUPT) {
 // bool  soft_serial_transaction(int sstd_index)
 //
 // this code is very time dependent, so we need to disable interrupts
-bool soft_serial_transaction(int sstd_index) {
+static bool serial_transaction(int sstd_index) {
     if (sstd_index > NUM_TOTAL_TRANSACTIONS) return false;
     split_transaction_desc_t *trans = &split_transaction_table[sstd_index];
 
@@ -498,6 +498,22 @@ bool soft_serial_transaction(int sstd_index) {
     sei();
     return true;
 }
+
+// Only the initiator counts transactions, the target answers them from its interrupt
+static serial_link_stats_t link_stats = {0};
+
+bool soft_serial_transaction(int sstd_index) {
+    link_stats.transactions++;
+    if (!serial_transaction(sstd_index)) {
+        link_stats.errors++;
+        return false;
+    }
+    return true;
+}
+
+const serial_link_stats_t *serial_link_get_stats(void) {
+    return &link_stats;
+}
 #else
 #    ifndef USE_I2C
 #        error SOFT_SERIAL_PIN or USE_I2C is required but has not been defined.
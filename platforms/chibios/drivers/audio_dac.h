@@ -119,8 +119,3 @@
 #if AUDIO_DAC_OFF_VALUE > AUDIO_DAC_SAMPLE_MAX
 #    error "AUDIO_DAC: OFF_VALUE may not be larger than SAMPLE_MAX"
 #endif
-
-/**
- *user overridable sample generation/processing
- */
-uint16_t dac_value_generate(void);
@@ -286,6 +286,9 @@ static inline bool initiate_transaction(uint8_t sstd_index) {
     return true;
 }
 
+// Only the initiator counts transactions, the target answers them from its interrupt
+static serial_link_stats_t link_stats = {0};
+
 /////////
 //  start transaction by initiator
 //
@@ -293,5 +296,14 @@ static inline bool initiate_transaction(uint8_t sstd_index) {
 //
 // this code is very time dependent, so we need to disable interrupts
 bool soft_serial_transaction(int sstd_index) {
-    return initiate_transaction((uint8_t)sstd_index);
+    link_stats.transactions++;
+    if (!initiate_transaction((uint8_t)sstd_index)) {
+        link_stats.errors++;
+        return false;
+    }
+    return true;
+}
+
+const serial_link_stats_t *serial_link_get_stats(void) {
+    return &link_stats;
 }
@@ -6,10 +6,89 @@
 #include "serial.h"
 #include "serial_protocol.h"
 #include "synchronization_util.h"
+#include "debug.h"
 
 static inline bool initiate_transaction(uint8_t transaction_id);
 static inline bool react_to_transaction(void);
 
+static serial_link_stats_t link_stats = {0};
+
+#if defined(SERIAL_USART_AUTO_SPEED)
+#    if !defined(SERIAL_DRIVER_USART)
+#        error SERIAL_USART_AUTO_SPEED is only supported by the usart driver.
+#    endif
+
+/* Handshake tokens from this value upwards request a speed step instead of
+ * starting a transaction. */
+#    define SPEED_REQUEST_ID 0xF0
+_Static_assert(NUM_TOTAL_TRANSACTIONS <= SPEED_REQUEST_ID, "Too many split transactions for SERIAL_USART_AUTO_SPEED");
+_Static_assert(SERIAL_USART_AUTO_SPEED_STEPS < 0x10, "SERIAL_USART_AUTO_SPEED_STEPS must be below 16");
+
+static uint8_t speed_step   = 0;
+static uint8_t speed_errors = 0;
+static uint8_t speed_limit  = SERIAL_USART_AUTO_SPEED_STEPS;
+
+static void set_speed_step(uint8_t step) {
+    speed_step            = step;
+    speed_errors          = 0;
+    link_stats.speed_step = step;
+    serial_transport_driver_set_speed_step(step);
+    dprintf("SPLIT: serial speed step %u\n", step);
+}
+
+/**
+ * @brief Counts a failed transaction and falls back to the base speed after
+ * SERIAL_USART_AUTO_SPEED_ERRORS failures in a row. Both halves do this on
+ * their own, so they always meet again at the base speed.
+ */
+static void speed_step_failed(void) {
+    if (speed_step > 0 && ++speed_errors >= SERIAL_USART_AUTO_SPEED_ERRORS) {
+        /* The master won't try this speed again. */
+        speed_limit = speed_step - 1;
+        link_stats.fallbacks++;
+        set_speed_step(0);
+    }
+}
+
+/**
+ * @brief Acknowledge a speed step request from the master and switch to it.
+ */
+static inline bool react_to_speed_request(uint8_t request_id) {
+    if (unlikely(request_id - SPEED_REQUEST_ID > SERIAL_USART_AUTO_SPEED_STEPS)) {
+        return false;
+    }
+
+    uint8_t handshake = request_id ^ NUM_TOTAL_TRANSACTIONS;
+    if (unlikely(!serial_transport_send(&handshake, sizeof(handshake)))) {
+        return false;
+    }
+
+    /* Let the handshake leave the wire before the baudrate changes. */
+    chThdSleepMilliseconds(SERIAL_USART_AUTO_SPEED_SWITCH_DELAY);
+    set_speed_step(request_id - SPEED_REQUEST_ID);
+    return true;
+}
+
+/**
+ * @brief Ask the slave to switch to a faster speed step. If the slave does not
+ * acknowledge, that step is given up.
+ */
+static void request_speed_step(uint8_t step) {
+    uint8_t request_id = SPEED_REQUEST_ID + step;
+    uint8_t handshake  = 0xFF;
+
+    serial_transport_driver_clear();
+    if (serial_transport_send(&request_id, sizeof(request_id)) && serial_transport_receive(&handshake, sizeof(handshake)) && handshake == (request_id ^ NUM_TOTAL_TRANSACTIONS)) {
+        /* Give the slave time to switch before talking to it again. */
+        chThdSleepMilliseconds(2 * SERIAL_USART_AUTO_SPEED_SWITCH_DELAY);
+        set_speed_step(step);
+    } else {
+        /* Should the slave have switched anyway, it falls back on its own. */
+        speed_limit = step - 1;
+    }
+}
+#endif // defined(SERIAL_USART_AUTO_SPEED)
+
 /**
  * @brief This thread runs on the slave and responds to transactions initiated
  * by the master.
@@ -20,10 +99,17 @@ static THD_FUNCTION(SlaveThread, arg) {
     chRegSetThreadName("split_protocol_tx_rx");
 
     while (true) {
+        link_stats.transactions++;
         if (unlikely(!react_to_transaction())) {
             /* Clear the receive queue, to start with a clean slate.
              * Parts of failed transactions or spurious bytes could still be in it. */
             serial_transport_driver_clear();
+            link_stats.errors++;
+#if defined(SERIAL_USART_AUTO_SPEED)
+            speed_step_failed();
+        } else {
+            speed_errors = 0;
+#endif
         }
     }
 }
@@ -55,6 +141,12 @@ static inline bool react_to_transaction(void) {
         return false;
     }
 
+#if defined(SERIAL_USART_AUTO_SPEED)
+    if (transaction_id >= SPEED_REQUEST_ID) {
+        return react_to_speed_request(transaction_id);
+    }
+#endif
+
     /* Sanity check that we are actually responding to a valid transaction. */
     if (unlikely(transaction_id >= NUM_TOTAL_TRANSACTIONS)) {
         return false;
@@ -104,7 +196,31 @@ bool soft_serial_transaction(int index) {
      * Parts of failed transactions or spurious bytes could still be in it. */
     serial_transport_driver_clear();
 
-    return initiate_transaction((uint8_t)index);
+    systime_t start = chVTGetSystemTimeX();
+    bool      okay  = initiate_transaction((uint8_t)index);
+
+    link_stats.transactions++;
+    if (unlikely(!okay)) {
+        link_stats.errors++;
+#if defined(SERIAL_USART_AUTO_SPEED)
+        speed_step_failed();
+#endif
+        return false;
+    }
+
+    link_stats.round_trip_us = TIME_I2US(chVTTimeElapsedSinceX(start));
+#if defined(SERIAL_USART_AUTO_SPEED)
+    speed_errors = 0;
+    /* Once the link works, step up to the fastest speed not yet given up. */
+    if (speed_step < speed_limit) {
+        request_speed_step(speed_limit);
+    }
+#endif
+    return true;
+}
+
+const serial_link_stats_t* serial_link_get_stats(void) {
+    return &link_stats;
 }
 
 /**
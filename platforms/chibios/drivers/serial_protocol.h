@@ -47,3 +47,26 @@ bool __attribute__((nonnull, hot)) serial_transport_receive_blocking(uint8_t* de
  * @return false Send failed, e.g. by timeout or bit errors.
  */
 bool __attribute__((nonnull, hot)) serial_transport_send(const uint8_t* source, const size_t size);
+
+#if defined(SERIAL_USART_AUTO_SPEED)
+/* How many times the baudrate is doubled at most, starting from SERIAL_USART_SPEED. */
+#    if !defined(SERIAL_USART_AUTO_SPEED_STEPS)
+#        define SERIAL_USART_AUTO_SPEED_STEPS 2
+#    endif
+
+/* Failed transactions in a row after which both halves fall back to SERIAL_USART_SPEED. */
+#    if !defined(SERIAL_USART_AUTO_SPEED_ERRORS)
+#        define SERIAL_USART_AUTO_SPEED_ERRORS 5
+#    endif
+
+/* Milliseconds the slave waits after acknowledging a speed change before switching. */
+#    if !defined(SERIAL_USART_AUTO_SPEED_SWITCH_DELAY)
+#        define SERIAL_USART_AUTO_SPEED_SWITCH_DELAY 2
+#    endif
+
+/**
+ * @brief Restarts the driver with a baudrate of SERIAL_USART_SPEED doubled
+ * step times.
+ */
+void serial_transport_driver_set_speed_step(uint8_t step);
+#endif
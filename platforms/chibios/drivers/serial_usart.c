@@ -50,6 +50,13 @@ static inline void usart_driver_start(void) {
     sdStart(serial_driver, &serial_config);
 }
 
+/**
+ * @brief SERIAL Driver stop routine.
+ */
+static inline void usart_driver_stop(void) {
+    sdStop(serial_driver);
+}
+
 inline void serial_transport_driver_clear(void) {
     osalSysLock();
     bool volatile queue_not_empty = !iqIsEmptyI(&serial_driver->iqueue);
@@ -80,6 +87,13 @@ static inline void usart_driver_start(void) {
     sioStart(serial_driver, &serial_config);
 }
 
+/**
+ * @brief SIO Driver stop routine.
+ */
+static inline void usart_driver_stop(void) {
+    sioStop(serial_driver);
+}
+
 inline void serial_transport_driver_clear(void) {
     if (sioHasRXErrorsX(serial_driver)) {
         sioGetAndClearErrors(serial_driver);
@@ -235,3 +249,15 @@ void serial_transport_driver_master_init(void) {
 
     usart_driver_start();
 }
+
+#if defined(SERIAL_USART_AUTO_SPEED)
+void serial_transport_driver_set_speed_step(uint8_t step) {
+    usart_driver_stop();
+#    if HAL_USE_SERIAL
+    serial_config.speed = (SERIAL_USART_SPEED) << step;
+#    else
+    serial_config.baud = (SERIAL_USART_SPEED) << step;
+#    endif
+    usart_driver_start();
+}
+#endif
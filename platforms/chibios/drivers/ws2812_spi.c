@@ -2,6 +2,7 @@
 #include "gpio.h"
 #include "util.h"
 #include "chibios_config.h"
+#include <string.h>
 
 /* Adapted from https://github.com/gamazeps/ws2812b-chibios-SPIDMA/ */
 
@@ -86,54 +87,69 @@
 #define RESET_SIZE (1000 * WS2812_TRST_US / (2 * WS2812_TIMING))
 #define PREAMBLE_SIZE 4
 
-static uint8_t txbuf[PREAMBLE_SIZE + DATA_SIZE + RESET_SIZE] = {0};
+#define TXBUF_SIZE (PREAMBLE_SIZE + DATA_SIZE + RESET_SIZE)
+
+// With async sends the next frame is encoded into one buffer while the DMA is
+// still shifting out the other. Circular mode keeps streaming a single buffer.
+#if defined(WS2812_SPI_USE_CIRCULAR_BUFFER) || defined(WS2812_SPI_SYNC)
+#    define TXBUF_COUNT 1
+#else
+#    define TXBUF_COUNT 2
+#endif
+
+static uint8_t txbuf[TXBUF_COUNT][TXBUF_SIZE] = {0};
+static uint8_t txbuf_index                    = 0;
+
+// The colors last written by ws2812_setleds(), and per buffer a bit for every
+// LED that changed since that buffer was encoded, so unchanged LEDs are not
+// encoded again.
+static rgb_led_t led_colors[WS2812_LED_COUNT];
+static uint8_t   txbuf_dirty[TXBUF_COUNT][(WS2812_LED_COUNT + 7) / 8];
+
+#if TXBUF_COUNT > 1
+static volatile bool txbuf_sending = false;
+
+static void ws2812_spi_end_cb(SPIDriver* spip) {
+    txbuf_sending = false;
+}
+#    define WS2812_SPI_END_CB ws2812_spi_end_cb
+#else
+#    define WS2812_SPI_END_CB NULL
+#endif
 
 /*
  * As the trick here is to use the SPI to send a huge pattern of 0 and 1 to
- * the ws2812b protocol, we use this helper function to translate bytes into
- * 0s and 1s for the LED (with the appropriate timing).
+ * the ws2812b protocol, each bit of a color is sent as four SPI bits: 0b1110
+ * for a one and 0b1000 for a zero. This table holds those four bytes for
+ * every possible color byte.
  */
-static uint8_t get_protocol_eq(uint8_t data, int pos) {
-    uint8_t eq = 0;
-    if (data & (1 << (2 * (3 - pos))))
-        eq = 0b1110;
-    else
-        eq = 0b1000;
-    if (data & (2 << (2 * (3 - pos))))
-        eq += 0b11100000;
-    else
-        eq += 0b10000000;
-    return eq;
-}
+#define WS2812_SPI_BITS(bits) ((((bits)&2) ? 0xE0 : 0x80) | (((bits)&1) ? 0x0E : 0x08))
+#define WS2812_SPI_LUT_1(n) \
+    { WS2812_SPI_BITS((n) >> 6), WS2812_SPI_BITS((n) >> 4), WS2812_SPI_BITS((n) >> 2), WS2812_SPI_BITS(n) }
+#define WS2812_SPI_LUT_4(n) WS2812_SPI_LUT_1(n), WS2812_SPI_LUT_1((n) + 1), WS2812_SPI_LUT_1((n) + 2), WS2812_SPI_LUT_1((n) + 3)
+#define WS2812_SPI_LUT_16(n) WS2812_SPI_LUT_4(n), WS2812_SPI_LUT_4((n) + 4), WS2812_SPI_LUT_4((n) + 8), WS2812_SPI_LUT_4((n) + 12)
+#define WS2812_SPI_LUT_64(n) WS2812_SPI_LUT_16(n), WS2812_SPI_LUT_16((n) + 16), WS2812_SPI_LUT_16((n) + 32), WS2812_SPI_LUT_16((n) + 48)
+
+static const uint8_t protocol_eq[256][BYTES_FOR_LED_BYTE] = {WS2812_SPI_LUT_64(0), WS2812_SPI_LUT_64(64), WS2812_SPI_LUT_64(128), WS2812_SPI_LUT_64(192)};
 
-static void set_led_color_rgb(rgb_led_t color, int pos) {
-    uint8_t* tx_start = &txbuf[PREAMBLE_SIZE];
+static void set_led_color_rgb(uint8_t* buffer, rgb_led_t color, int pos) {
+    uint8_t* tx_start = &buffer[PREAMBLE_SIZE + BYTES_FOR_LED * pos];
 
 #if (WS2812_BYTE_ORDER == WS2812_BYTE_ORDER_GRB)
-    for (int j = 0; j < 4; j++)
-        tx_start[BYTES_FOR_LED * pos + j] = get_protocol_eq(color.g, j);
-    for (int j = 0; j < 4; j++)
-        tx_start[BYTES_FOR_LED * pos + BYTES_FOR_LED_BYTE + j] = get_protocol_eq(color.r, j);
-    for (int j = 0; j < 4; j++)
-        tx_start[BYTES_FOR_LED * pos + BYTES_FOR_LED_BYTE * 2 + j] = get_protocol_eq(color.b, j);
+    memcpy(tx_start, protocol_eq[color.g], BYTES_FOR_LED_BYTE);
+    memcpy(tx_start + BYTES_FOR_LED_BYTE, protocol_eq[color.r], BYTES_FOR_LED_BYTE);
+    memcpy(tx_start + BYTES_FOR_LED_BYTE * 2, protocol_eq[color.b], BYTES_FOR_LED_BYTE);
 #elif (WS2812_BYTE_ORDER == WS2812_BYTE_ORDER_RGB)
-    for (int j = 0; j < 4; j++)
-        tx_start[BYTES_FOR_LED * pos + j] = get_protocol_eq(color.r, j);
-    for (int j = 0; j < 4; j++)
-        tx_start[BYTES_FOR_LED * pos + BYTES_FOR_LED_BYTE + j] = get_protocol_eq(color.g, j);
-    for (int j = 0; j < 4; j++)
-        tx_start[BYTES_FOR_LED * pos + BYTES_FOR_LED_BYTE * 2 + j] = get_protocol_eq(color.b, j);
+    memcpy(tx_start, protocol_eq[color.r], BYTES_FOR_LED_BYTE);
+    memcpy(tx_start + BYTES_FOR_LED_BYTE, protocol_eq[color.g], BYTES_FOR_LED_BYTE);
+    memcpy(tx_start + BYTES_FOR_LED_BYTE * 2, protocol_eq[color.b], BYTES_FOR_LED_BYTE);
 #elif (WS2812_BYTE_ORDER == WS2812_BYTE_ORDER_BGR)
-    for (int j = 0; j < 4; j++)
-        tx_start[BYTES_FOR_LED * pos + j] = get_protocol_eq(color.b, j);
-    for (int j = 0; j < 4; j++)
-        tx_start[BYTES_FOR_LED * pos + BYTES_FOR_LED_BYTE + j] = get_protocol_eq(color.g, j);
-    for (int j = 0; j < 4; j++)
-        tx_start[BYTES_FOR_LED * pos + BYTES_FOR_LED_BYTE * 2 + j] = get_protocol_eq(color.r, j);
+    memcpy(tx_start, protocol_eq[color.b], BYTES_FOR_LED_BYTE);
+    memcpy(tx_start + BYTES_FOR_LED_BYTE, protocol_eq[color.g], BYTES_FOR_LED_BYTE);
+    memcpy(tx_start + BYTES_FOR_LED_BYTE * 2, protocol_eq[color.r], BYTES_FOR_LED_BYTE);
 #endif
 #ifdef RGBW
-    for (int j = 0; j < 4; j++)
-        tx_start[BYTES_FOR_LED * pos + BYTES_FOR_LED_BYTE * 4 + j] = get_protocol_eq(color.w, j);
+    memcpy(tx_start + BYTES_FOR_LED_BYTE * 3, protocol_eq[color.w], BYTES_FOR_LED_BYTE);
 #endif
 }
 
@@ -151,7 +167,7 @@ void ws2812_init(void) {
 #    if SPI_SUPPORTS_CIRCULAR == TRUE
         WS2812_SPI_BUFFER_MODE,
 #    endif
-        NULL, // end_cb
+        WS2812_SPI_END_CB, // end_cb
         PAL_PORT(WS2812_DI_PIN),
         PAL_PAD(WS2812_DI_PIN),
 #    if defined(WB32F3G71xx) || defined(WB32FQ95xx)
@@ -170,7 +186,7 @@ void ws2812_init(void) {
 #    if SPI_SUPPORTS_SLAVE_MODE == TRUE
         false,
 #    endif
-        NULL, // data_cb
+        WS2812_SPI_END_CB, // data_cb
         NULL, // error_cb
         PAL_PORT(WS2812_DI_PIN),
         PAL_PAD(WS2812_DI_PIN),
@@ -179,11 +195,14 @@ void ws2812_init(void) {
 #endif
     };
 
+    // Every LED has to be encoded at least once, even if it starts out black
+    memset(txbuf_dirty, 0xFF, sizeof(txbuf_dirty));
+
     spiAcquireBus(&WS2812_SPI_DRIVER);     /* Acquire ownership of the bus.    */
     spiStart(&WS2812_SPI_DRIVER, &spicfg); /* Setup transfer parameters.       */
     spiSelect(&WS2812_SPI_DRIVER);         /* Slave Select assertion.          */
 #ifdef WS2812_SPI_USE_CIRCULAR_BUFFER
-    spiStartSend(&WS2812_SPI_DRIVER, ARRAY_SIZE(txbuf), txbuf);
+    spiStartSend(&WS2812_SPI_DRIVER, TXBUF_SIZE, txbuf[0]);
 #endif
 }
 
@@ -194,17 +213,38 @@ void ws2812_setleds(rgb_led_t* ledarray, uint16_t leds) {
         s_init = true;
     }
 
-    for (uint8_t i = 0; i < leds; i++) {
-        set_led_color_rgb(ledarray[i], i);
+    if (leds > WS2812_LED_COUNT) {
+        leds = WS2812_LED_COUNT;
+    }
+
+    uint8_t* buffer = txbuf[txbuf_index];
+    uint8_t* dirty  = txbuf_dirty[txbuf_index];
+    for (uint16_t i = 0; i < leds; i++) {
+        if (memcmp(&ledarray[i], &led_colors[i], sizeof(rgb_led_t)) != 0) {
+            led_colors[i] = ledarray[i];
+            for (uint8_t j = 0; j < TXBUF_COUNT; j++) {
+                txbuf_dirty[j][i / 8] |= 1 << (i % 8);
+            }
+        }
+        if (dirty[i / 8] & (1 << (i % 8))) {
+            dirty[i / 8] &= ~(1 << (i % 8));
+            set_led_color_rgb(buffer, ledarray[i], i);
+        }
     }
 
-    // Send async - each led takes ~0.03ms, 50 leds ~1.5ms, animations flushing faster than send will cause issues.
+    // Send async - each led takes ~0.03ms, 50 leds ~1.5ms. The next frame is
+    // encoded into the other buffer while this one is sent, and only waits
+    // here if animations flush faster than the LEDs can be updated.
     // Instead spiSend can be used to send synchronously (or the thread logic can be added back).
 #ifndef WS2812_SPI_USE_CIRCULAR_BUFFER
 #    ifdef WS2812_SPI_SYNC
-    spiSend(&WS2812_SPI_DRIVER, ARRAY_SIZE(txbuf), txbuf);
+    spiSend(&WS2812_SPI_DRIVER, TXBUF_SIZE, buffer);
 #    else
-    spiStartSend(&WS2812_SPI_DRIVER, ARRAY_SIZE(txbuf), txbuf);
+    while (txbuf_sending) {
+    }
+    txbuf_sending = true;
+    spiStartSend(&WS2812_SPI_DRIVER, TXBUF_SIZE, buffer);
+    txbuf_index = (txbuf_index + 1) % TXBUF_COUNT;
 #    endif
 #endif
 }
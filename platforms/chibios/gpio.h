@@ -43,3 +43,11 @@ typedef ioline_t pin_t;
 #define readPin(pin) palReadLine(pin)
 
 #define togglePin(pin) palToggleLine(pin)
+
+/* Operation of GPIO by port. */
+
+typedef ioportmask_t port_data_t;
+
+#define readPort(pin) palReadPort(PAL_PORT(pin))
+#define getPinPort(pin) PAL_PORT(pin)
+#define getPinBit(pin) PAL_PAD(pin)
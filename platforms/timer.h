@@ -47,6 +47,9 @@ uint32_t timer_elapsed32(uint32_t last);
 #define timer_expired(current, future) ((uint16_t)(current - future) < UINT16_MAX / 2)
 #define timer_expired32(current, future) ((uint32_t)(current - future) < UINT32_MAX / 2)
 
+// Returned by the *_next_deadline() queries when nothing is waiting on the timer
+#define TIMER_NO_DEADLINE UINT32_MAX
+
 // Use an appropriate timer integer size based on architecture (16-bit will overflow sooner)
 #if FAST_TIMER_T_SIZE < 32
 #    define TIMER_DIFF_FAST(a, b) TIMER_DIFF_16(a, b)
@@ -112,6 +112,31 @@ void action_tapping_process(keyrecord_t record) {
     }
 }
 
+/** \brief Time until the tapping key may resolve on its own
+ *
+ * Returns the milliseconds left before the pending tapping key reaches its
+ * tapping term, or retro shift term, or TIMER_NO_DEADLINE if no tapping key
+ * is pending. Once every term has passed it returns 0, as the key may then
+ * resolve on any tick.
+ */
+uint32_t action_tapping_next_deadline(void) {
+    if (IS_NOEVENT(tapping_key.event)) {
+        return TIMER_NO_DEADLINE;
+    }
+
+    uint16_t elapsed = TIMER_DIFF_16(timer_read(), tapping_key.event.time);
+    uint16_t term    = GET_TAPPING_TERM(get_record_keycode(&tapping_key, false), &tapping_key);
+    if (elapsed < term) {
+        return term - elapsed;
+    }
+#    if defined(AUTO_SHIFT_ENABLE) && defined(RETRO_SHIFT)
+    if (elapsed < (RETRO_SHIFT + 0)) {
+        return (RETRO_SHIFT + 0) - elapsed;
+    }
+#    endif
+    return 0;
+}
+
 /* Some conditionally defined helper macros to keep process_tapping more
  * readable. The conditional definition of tapping_keycode and all the
  * conditional uses of it are hidden inside macros named TAP_...
@@ -21,6 +21,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "action_layer.h"
 #include "timer.h"
 #include "keycode_config.h"
+#include "util.h"
 #include <string.h>
 
 extern keymap_config_t keymap_config;
@@ -165,6 +166,35 @@ void clear_oneshot_swaphands(void) {
 
 #    endif
 
+#    if (defined(ONESHOT_TIMEOUT) && (ONESHOT_TIMEOUT > 0))
+static uint32_t oneshot_time_left(uint16_t time) {
+    uint16_t elapsed = TIMER_DIFF_16(timer_read(), time);
+    return elapsed < ONESHOT_TIMEOUT ? ONESHOT_TIMEOUT - elapsed : 0;
+}
+#    endif
+
+/** \brief Time until an active oneshot mod, layer or swap hands times out
+ *
+ * Returns TIMER_NO_DEADLINE if none is active or ONESHOT_TIMEOUT is not set.
+ */
+uint32_t oneshot_next_deadline(void) {
+    uint32_t deadline = TIMER_NO_DEADLINE;
+#    if (defined(ONESHOT_TIMEOUT) && (ONESHOT_TIMEOUT > 0))
+    if (get_oneshot_mods()) {
+        deadline = MIN(deadline, oneshot_time_left(oneshot_time));
+    }
+    if (get_oneshot_layer_state() && !(get_oneshot_layer_state() & ONESHOT_TOGGLED)) {
+        deadline = MIN(deadline, oneshot_time_left(oneshot_layer_time));
+    }
+#        ifdef SWAP_HANDS_ENABLE
+    if (swap_hands_oneshot == SHO_ACTIVE) {
+        deadline = MIN(deadline, oneshot_time_left(oneshot_swaphands_time));
+    }
+#        endif
+#    endif
+    return deadline;
+}
+
 /** \brief Set oneshot layer
  *
  * FIXME: needs doc
@@ -283,6 +313,7 @@ static uint8_t get_mods_for_report(void) {
 }
 
 void send_6kro_report(void) {
+    sync_6kro_report();
     keyboard_report->mods = get_mods_for_report();
 
 #ifdef PROTOCOL_VUSB
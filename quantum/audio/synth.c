@@ -0,0 +1,287 @@
+/* Copyright 2024 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "synth.h"
+
+/* Samples inside the synthesizer are signed Q15, envelope levels and gains
+ * are Q15 fractions of one (32768).  Only the final mix is converted to the
+ * unsigned output range.
+ */
+#define Q15_ONE 32768
+
+// samples rendered per pass, bounding the mix buffer
+#define RENDER_CHUNK_SIZE 32
+
+// one full sine wave, with a guard entry for interpolation
+static const int16_t sine_table[AUDIO_SYNTH_WAVETABLE_LENGTH] = {
+    0, 804, 1608, 2410, 3212, 4011, 4808, 5602, 6393, 7179, 7962, 8739, 9512, 10278, 11039, 11793,
+    12539, 13279, 14010, 14732, 15446, 16151, 16846, 17530, 18204, 18868, 19519, 20159, 20787, 21403, 22005, 22594,
+    23170, 23731, 24279, 24811, 25329, 25832, 26319, 26790, 27245, 27683, 28105, 28510, 28898, 29268, 29621, 29956,
+    30273, 30571, 30852, 31113, 31356, 31580, 31785, 31971, 32137, 32285, 32412, 32521, 32609, 32678, 32728, 32757,
+    32767, 32757, 32728, 32678, 32609, 32521, 32412, 32285, 32137, 31971, 31785, 31580, 31356, 31113, 30852, 30571,
+    30273, 29956, 29621, 29268, 28898, 28510, 28105, 27683, 27245, 26790, 26319, 25832, 25329, 24811, 24279, 23731,
+    23170, 22594, 22005, 21403, 20787, 20159, 19519, 18868, 18204, 17530, 16846, 16151, 15446, 14732, 14010, 13279,
+    12539, 11793, 11039, 10278, 9512, 8739, 7962, 7179, 6393, 5602, 4808, 4011, 3212, 2410, 1608, 804,
+    0, -804, -1608, -2410, -3212, -4011, -4808, -5602, -6393, -7179, -7962, -8739, -9512, -10278, -11039, -11793,
+    -12539, -13279, -14010, -14732, -15446, -16151, -16846, -17530, -18204, -18868, -19519, -20159, -20787, -21403, -22005, -22594,
+    -23170, -23731, -24279, -24811, -25329, -25832, -26319, -26790, -27245, -27683, -28105, -28510, -28898, -29268, -29621, -29956,
+    -30273, -30571, -30852, -31113, -31356, -31580, -31785, -31971, -32137, -32285, -32412, -32521, -32609, -32678, -32728, -32757,
+    -32767, -32757, -32728, -32678, -32609, -32521, -32412, -32285, -32137, -31971, -31785, -31580, -31356, -31113, -30852, -30571,
+    -30273, -29956, -29621, -29268, -28898, -28510, -28105, -27683, -27245, -26790, -26319, -25832, -25329, -24811, -24279, -23731,
+    -23170, -22594, -22005, -21403, -20787, -20159, -19519, -18868, -18204, -17530, -16846, -16151, -15446, -14732, -14010, -13279,
+    -12539, -11793, -11039, -10278, -9512, -8739, -7962, -7179, -6393, -5602, -4808, -4011, -3212, -2410, -1608, -804,
+    0,
+};
+
+typedef enum {
+    VOICE_OFF,
+    VOICE_ATTACK,
+    VOICE_SUSTAIN,
+    VOICE_RELEASE,
+} voice_state_t;
+
+typedef struct {
+    float         pitch;
+    uint32_t      phase;
+    uint32_t      increment;
+    int32_t       level;
+    voice_state_t state;
+} voice_t;
+
+static voice_t voices[AUDIO_SYNTH_VOICES];
+
+static const int16_t         *wavetable    = sine_table;
+static audio_synth_waveform_t waveform     = AUDIO_SYNTH_WAVEFORM_SINE;
+static float                  phase_per_hz = 0.0f;
+static int32_t                attack_step  = Q15_ONE;
+static int32_t                release_step = Q15_ONE;
+static int32_t                gain         = Q15_ONE;
+static uint16_t               output_max   = 0;
+static uint16_t               output_off   = 0;
+
+static int32_t envelope_step(uint32_t sample_rate, uint16_t ms) {
+    uint32_t samples = sample_rate * ms / 1000;
+    return samples > 0 && samples < Q15_ONE ? Q15_ONE / samples : Q15_ONE;
+}
+
+void audio_synth_init(uint32_t sample_rate, uint16_t sample_max, uint16_t off_value) {
+    for (uint8_t i = 0; i < AUDIO_SYNTH_VOICES; i++) {
+        voices[i].state = VOICE_OFF;
+        voices[i].level = 0;
+    }
+    // one phase accumulator cycle is 2^32
+    phase_per_hz = 4294967296.0f / sample_rate;
+    attack_step  = envelope_step(sample_rate, AUDIO_SYNTH_ATTACK_MS);
+    release_step = envelope_step(sample_rate, AUDIO_SYNTH_RELEASE_MS);
+    gain         = Q15_ONE;
+    output_max   = sample_max;
+    output_off   = off_value;
+}
+
+static uint32_t frequency_to_increment(float frequency) {
+    float increment = frequency * phase_per_hz;
+    // anything at or above the Nyquist frequency would only alias
+    return increment < 2147483648.0f ? increment : 0;
+}
+
+void audio_synth_set_waveform(audio_synth_waveform_t new_waveform) {
+    if (new_waveform == AUDIO_SYNTH_WAVEFORM_CUSTOM) {
+        return;
+    }
+    waveform  = new_waveform;
+    wavetable = sine_table;
+}
+
+void audio_synth_set_wavetable(const int16_t *table) {
+    if (table) {
+        wavetable = table;
+        waveform  = AUDIO_SYNTH_WAVEFORM_CUSTOM;
+    } else {
+        audio_synth_set_waveform(AUDIO_SYNTH_WAVEFORM_SINE);
+    }
+}
+
+void audio_synth_set_tones(const float *pitches, const float *frequencies, uint8_t count) {
+    bool matched[AUDIO_SYNTH_VOICES] = {false};
+
+    // keep voices whose tone is still playing, let the others fade out
+    for (uint8_t v = 0; v < AUDIO_SYNTH_VOICES; v++) {
+        if (voices[v].state == VOICE_OFF) {
+            continue;
+        }
+        bool found = false;
+        for (uint8_t t = 0; t < count; t++) {
+            if (pitches[t] == voices[v].pitch) {
+                voices[v].increment = frequency_to_increment(frequencies[t]);
+                if (voices[v].state == VOICE_RELEASE) {
+                    voices[v].state = VOICE_ATTACK;
+                }
+                found = true;
+                break;
+            }
+        }
+        if (!found && voices[v].state != VOICE_RELEASE) {
+            voices[v].state = VOICE_RELEASE;
+        }
+        matched[v] = found;
+    }
+
+    // start voices for new tones, taking over the quietest fading voice if all are busy
+    for (uint8_t t = 0; t < count; t++) {
+        bool playing = false;
+        for (uint8_t v = 0; v < AUDIO_SYNTH_VOICES; v++) {
+            if (matched[v] && voices[v].pitch == pitches[t]) {
+                playing = true;
+                break;
+            }
+        }
+        if (playing) {
+            continue;
+        }
+
+        int8_t target = -1;
+        for (uint8_t v = 0; v < AUDIO_SYNTH_VOICES; v++) {
+            if (voices[v].state == VOICE_OFF) {
+                target = v;
+                break;
+            }
+            if (voices[v].state == VOICE_RELEASE && (target < 0 || voices[v].level < voices[target].level)) {
+                target = v;
+            }
+        }
+        if (target < 0) {
+            // more tones than voices
+            break;
+        }
+
+        if (voices[target].state == VOICE_OFF) {
+            voices[target].phase = 0;
+        }
+        voices[target].pitch     = pitches[t];
+        voices[target].increment = frequency_to_increment(frequencies[t]);
+        voices[target].state     = VOICE_ATTACK;
+        matched[target]          = true;
+    }
+}
+
+void audio_synth_release_all(void) {
+    for (uint8_t v = 0; v < AUDIO_SYNTH_VOICES; v++) {
+        if (voices[v].state != VOICE_OFF) {
+            voices[v].state = VOICE_RELEASE;
+        }
+    }
+}
+
+bool audio_synth_is_active(void) {
+    for (uint8_t v = 0; v < AUDIO_SYNTH_VOICES; v++) {
+        if (voices[v].state != VOICE_OFF) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static inline int32_t waveform_sample(uint32_t phase) {
+    switch (waveform) {
+        case AUDIO_SYNTH_WAVEFORM_TRIANGLE: {
+            int32_t p = phase >> 16;
+            return p < 0x8000 ? p * 2 - 32767 : 32767 - (p - 0x8000) * 2;
+        }
+        case AUDIO_SYNTH_WAVEFORM_TRAPEZOID: {
+            int32_t p = phase >> 16;
+            int32_t t = 3 * (p < 0x8000 ? p * 2 - 32767 : 32767 - (p - 0x8000) * 2);
+            return t > 32767 ? 32767 : (t < -32767 ? -32767 : t);
+        }
+        case AUDIO_SYNTH_WAVEFORM_SQUARE:
+            return phase < 0x80000000 ? -32767 : 32767;
+        case AUDIO_SYNTH_WAVEFORM_SAWTOOTH:
+            return (int32_t)(phase >> 16) - 32768;
+        default: {
+            // linear interpolation between neighbouring table entries
+            uint32_t index = phase >> 24;
+            int32_t  frac  = (phase >> 8) & 0xFFFF;
+            int32_t  a     = wavetable[index];
+            int32_t  b     = wavetable[index + 1];
+            return a + (((b - a) * frac) >> 16);
+        }
+    }
+}
+
+static void render_chunk(uint16_t *buffer, uint8_t length) {
+    int32_t mix[RENDER_CHUNK_SIZE] = {0};
+    uint8_t sounding               = 0;
+
+    for (uint8_t v = 0; v < AUDIO_SYNTH_VOICES; v++) {
+        voice_t *voice = &voices[v];
+        if (voice->state == VOICE_OFF) {
+            continue;
+        }
+        sounding++;
+
+        uint32_t phase = voice->phase;
+        int32_t  level = voice->level;
+        for (uint8_t n = 0; n < length; n++) {
+            switch (voice->state) {
+                case VOICE_ATTACK:
+                    level += attack_step;
+                    if (level >= Q15_ONE) {
+                        level        = Q15_ONE;
+                        voice->state = VOICE_SUSTAIN;
+                    }
+                    break;
+                case VOICE_RELEASE:
+                    level -= release_step;
+                    if (level <= 0) {
+                        level        = 0;
+                        voice->state = VOICE_OFF;
+                    }
+                    break;
+                default:
+                    break;
+            }
+
+            // scale the signed sample to output units relative to the off value
+            int32_t sample = (((waveform_sample(phase) + 32768) * output_max) >> 16) - output_off;
+            mix[n] += (sample * level) >> 15;
+            phase += voice->increment;
+        }
+        voice->phase = phase;
+        voice->level = level;
+    }
+
+    /* Voices are mixed at 1/N volume for N sounding voices, like the additive
+     * driver always did; ramp towards the new gain across the chunk so that
+     * tones starting or stopping do not step the volume of the others.
+     */
+    int32_t target = sounding > 1 ? Q15_ONE / sounding : Q15_ONE;
+    int32_t step   = (target - gain) / length;
+
+    for (uint8_t n = 0; n < length; n++) {
+        gain += step;
+        int32_t value = output_off + ((mix[n] * gain) >> 15);
+        buffer[n]     = value < 0 ? 0 : (value > output_max ? output_max : value);
+    }
+    gain = target;
+}
+
+void audio_synth_render(uint16_t *buffer, size_t length) {
+    while (length > 0) {
+        uint8_t chunk = length > RENDER_CHUNK_SIZE ? RENDER_CHUNK_SIZE : length;
+        render_chunk(buffer, chunk);
+        buffer += chunk;
+        length -= chunk;
+    }
+}
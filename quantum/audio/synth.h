@@ -0,0 +1,121 @@
+/* Copyright 2024 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * Fixed-point wavetable synthesizer, rendering whole blocks of samples for
+ * drivers that stream audio through DMA (e.g. dac_additive).
+ *
+ * Each voice has its own 32-bit phase accumulator and a linear attack/release
+ * envelope, so tones can start, stop and change pitch at any point in a block
+ * without clicks and without waiting for the waveform to cross zero.
+ */
+
+/**
+ * The number of voices that can sound at once, including ones that are
+ * fading out after their tone stopped.
+ */
+#ifndef AUDIO_SYNTH_VOICES
+#    ifdef AUDIO_MAX_SIMULTANEOUS_TONES
+#        define AUDIO_SYNTH_VOICES AUDIO_MAX_SIMULTANEOUS_TONES
+#    else
+#        define AUDIO_SYNTH_VOICES 8
+#    endif
+#endif
+
+/**
+ * Duration of the envelope ramps when a tone starts and stops.
+ */
+#ifndef AUDIO_SYNTH_ATTACK_MS
+#    define AUDIO_SYNTH_ATTACK_MS 2
+#endif
+#ifndef AUDIO_SYNTH_RELEASE_MS
+#    define AUDIO_SYNTH_RELEASE_MS 10
+#endif
+
+/**
+ * Number of entries in a wavetable, plus one guard entry (equal to the first)
+ * used for interpolating past the end of the table.
+ */
+#define AUDIO_SYNTH_WAVETABLE_SIZE 256
+#define AUDIO_SYNTH_WAVETABLE_LENGTH (AUDIO_SYNTH_WAVETABLE_SIZE + 1)
+
+typedef enum {
+    AUDIO_SYNTH_WAVEFORM_SINE,
+    AUDIO_SYNTH_WAVEFORM_TRIANGLE,
+    AUDIO_SYNTH_WAVEFORM_TRAPEZOID,
+    AUDIO_SYNTH_WAVEFORM_SQUARE,
+    AUDIO_SYNTH_WAVEFORM_SAWTOOTH,
+    AUDIO_SYNTH_WAVEFORM_CUSTOM,
+} audio_synth_waveform_t;
+
+/**
+ * @brief Reset all voices and set up the output format.
+ *
+ * @param sample_rate rate at which rendered samples are played back, in Hz
+ * @param sample_max the largest output sample value, full scale
+ * @param off_value the output sample value for silence
+ */
+void audio_synth_init(uint32_t sample_rate, uint16_t sample_max, uint16_t off_value);
+
+/**
+ * @brief Select one of the built-in waveforms.
+ */
+void audio_synth_set_waveform(audio_synth_waveform_t waveform);
+
+/**
+ * @brief Play a custom waveform.
+ *
+ * @param table AUDIO_SYNTH_WAVETABLE_LENGTH signed samples covering one
+ *              period, with the last entry repeating the first
+ */
+void audio_synth_set_wavetable(const int16_t *table);
+
+/**
+ * @brief Update the set of tones being played.
+ *
+ * Tones are matched to voices by their pitch, so a tone that keeps playing
+ * keeps its phase and envelope even if its processed frequency changes
+ * (vibrato, glissando).  Voices whose tone is no longer present fade out,
+ * new tones fade in.
+ *
+ * @param pitches the nominal pitch of each tone, used to identify it
+ * @param frequencies the frequency to actually play for each tone, in Hz
+ * @param count the number of tones
+ */
+void audio_synth_set_tones(const float *pitches, const float *frequencies, uint8_t count);
+
+/**
+ * @brief Fade out every voice.
+ */
+void audio_synth_release_all(void);
+
+/**
+ * @brief Check whether any voice is still audible.
+ */
+bool audio_synth_is_active(void);
+
+/**
+ * @brief Render the next block of samples.
+ *
+ * @param buffer destination for the samples, in the range [0, sample_max]
+ * @param length the number of samples to render
+ */
+void audio_synth_render(uint16_t *buffer, size_t length);
@@ -0,0 +1,139 @@
+// Copyright 2023 QMK
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "basic_profiling.h"
+#include "print.h"
+#include "timer.h"
+
+#if defined(__AVR__)
+#    include <avr/io.h>
+#    include <util/atomic.h>
+#    include "timer_avr.h"
+
+extern volatile uint32_t timer_count;
+
+// Timer0 restarts every millisecond, so whole milliseconds come from the
+// system timer and the remainder from the counter itself.
+#    define PROFILE_TICKS_PER_MS (TIMER_RAW_TOP + 1)
+#    if defined(TIFR0)
+#        define PROFILE_TIMER_OVERFLOWED() (TIFR0 & _BV(OCF0A))
+#    else
+#        define PROFILE_TIMER_OVERFLOWED() (TIFR & _BV(OCF0))
+#    endif
+
+uint32_t profile_timestamp(void) {
+    uint32_t ms;
+    uint8_t  ticks;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        ms    = timer_count;
+        ticks = TIMER_RAW;
+        if (PROFILE_TIMER_OVERFLOWED()) {
+            // The compare match is pending, the counter has already wrapped
+            ms++;
+            ticks = TIMER_RAW;
+        }
+    }
+    return ms * PROFILE_TICKS_PER_MS + ticks;
+}
+
+uint32_t profile_timestamp_frequency(void) {
+    return PROFILE_TICKS_PER_MS * 1000UL;
+}
+#elif defined(PROTOCOL_CHIBIOS)
+#    include <ch.h>
+#    include "chibios_config.h"
+
+// The realtime counter is the DWT cycle counter on Cortex-M3 and above
+uint32_t profile_timestamp(void) {
+    return chSysGetRealtimeCounterX();
+}
+
+uint32_t profile_timestamp_frequency(void) {
+    return REALTIME_COUNTER_CLOCK;
+}
+#elif defined(PROTOCOL_ARM_ATSAM)
+#    error arm_atsam not currently supported
+#else
+#    include <time.h>
+
+uint32_t profile_timestamp(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)(now.tv_sec * 1000000000ULL + now.tv_nsec);
+}
+
+uint32_t profile_timestamp_frequency(void) {
+    return 1000000000UL;
+}
+#endif
+
+static profile_zone_t *zones = NULL;
+
+void profile_zone_record(profile_zone_t *zone, uint32_t ticks) {
+    if (!zone->linked) {
+        zone->next   = zones;
+        zone->linked = true;
+        zones        = zone;
+    }
+
+    if (zone->count == 0 || ticks < zone->min) {
+        zone->min = ticks;
+    }
+    if (ticks > zone->max) {
+        zone->max = ticks;
+    }
+    zone->count++;
+    zone->total += ticks;
+
+    uint8_t bucket = ticks ? sizeof(unsigned long) * 8 - __builtin_clzl(ticks) : 0;
+    if (bucket >= PROFILE_HISTOGRAM_BUCKETS) {
+        bucket = PROFILE_HISTOGRAM_BUCKETS - 1;
+    }
+    if (zone->histogram[bucket] < UINT16_MAX) {
+        zone->histogram[bucket]++;
+    }
+}
+
+profile_zone_t *profile_zones(void) {
+    return zones;
+}
+
+void profile_zones_print(void) {
+    xprintf("profile: %lu ticks/s\n", (unsigned long)profile_timestamp_frequency());
+    for (profile_zone_t *zone = zones; zone; zone = zone->next) {
+        if (!zone->count) {
+            continue;
+        }
+        xprintf("profile: %s count %lu min %lu avg %lu max %lu\n", zone->name, (unsigned long)zone->count, (unsigned long)zone->min, (unsigned long)(zone->total / zone->count), (unsigned long)zone->max);
+        xprintf("profile: %s <2^n", zone->name);
+        for (uint8_t bucket = 0; bucket < PROFILE_HISTOGRAM_BUCKETS; bucket++) {
+            if (zone->histogram[bucket]) {
+                xprintf(" %u:%u", bucket, zone->histogram[bucket]);
+            }
+        }
+        xprintf("\n");
+    }
+}
+
+void profile_zones_reset(void) {
+    for (profile_zone_t *zone = zones; zone; zone = zone->next) {
+        zone->count = 0;
+        zone->min   = 0;
+        zone->max   = 0;
+        zone->total = 0;
+        for (uint8_t bucket = 0; bucket < PROFILE_HISTOGRAM_BUCKETS; bucket++) {
+            zone->histogram[bucket] = 0;
+        }
+    }
+}
+
+void profile_zones_task(void) {
+#if defined(CONSOLE_ENABLE) && PROFILE_ZONES_PRINT_INTERVAL > 0
+    static uint32_t last_print = 0;
+    if (timer_elapsed32(last_print) >= PROFILE_ZONES_PRINT_INTERVAL) {
+        last_print = timer_read32();
+        profile_zones_print();
+        profile_zones_reset();
+    }
+#endif
+}
@@ -19,16 +19,95 @@
         PROFILE_CALL_NAMED(1000, "matrix_task", {
             matrix_task();
         });
+
+    For a per-stage breakdown, set PROFILE_ZONES_ENABLE = yes in rules.mk.
+    Each PROFILE_ZONE() keeps the count, minimum, maximum, total and a log2
+    histogram of the time spent in it. With CONSOLE_ENABLE they are printed
+    every PROFILE_ZONES_PRINT_INTERVAL milliseconds, and profile_zones() gives
+    access to them for sending elsewhere, such as over raw HID. The core already has zones
+    around matrix scanning, key events, each process_record handler, RGB/LED
+    matrix tasks, split transactions and Quantum Painter flushes.
+
+        // Statements:
+        PROFILE_ZONE("my_task", my_task());
+
+        // Expressions, evaluating to the result of the call:
+        bool handled = PROFILE_ZONE_EXPR("my_handler", my_handler(keycode, record));
+
+    Without PROFILE_ZONES_ENABLE, both expand to just the call.
 */
 
+#include <stdbool.h>
+#include <stdint.h>
+
 #if defined(PROTOCOL_LUFA) || defined(PROTOCOL_VUSB)
 #    define TIMESTAMP_GETTER TCNT0
 #elif defined(PROTOCOL_CHIBIOS)
 #    define TIMESTAMP_GETTER chSysGetRealtimeCounterX()
-#elif defined(PROTOCOL_ARM_ATSAM)
-#    error arm_atsam not currently supported
+#elif !defined(PROTOCOL_ARM_ATSAM)
+#    define TIMESTAMP_GETTER profile_timestamp()
+#endif
+
+#ifndef PROFILE_HISTOGRAM_BUCKETS
+#    define PROFILE_HISTOGRAM_BUCKETS 20
+#endif
+
+#ifndef PROFILE_ZONES_PRINT_INTERVAL
+#    define PROFILE_ZONES_PRINT_INTERVAL 10000
+#endif
+
+typedef struct profile_zone_t {
+    const char *           name;
+    struct profile_zone_t *next;
+    bool                   linked;
+    uint32_t               count;
+    uint32_t               min;
+    uint32_t               max;
+    uint64_t               total;
+    // Bucket n counts the calls that took less than 2^n ticks, the last one
+    // everything longer.
+    uint16_t histogram[PROFILE_HISTOGRAM_BUCKETS];
+} profile_zone_t;
+
+/** \brief Returns the free running profiling timer, which ticks at profile_timestamp_frequency(). */
+uint32_t profile_timestamp(void);
+
+uint32_t profile_timestamp_frequency(void);
+
+/** \brief Adds one call taking `ticks` to a zone. */
+void profile_zone_record(profile_zone_t *zone, uint32_t ticks);
+
+/** \brief Returns the first zone that has been entered, the rest follow through `next`. */
+profile_zone_t *profile_zones(void);
+
+void profile_zones_print(void);
+
+void profile_zones_reset(void);
+
+void profile_zones_task(void);
+
+#ifdef PROFILE_ZONES_ENABLE
+#    define PROFILE_ZONE(zone_name, call)                                              \
+        do {                                                                           \
+            static profile_zone_t profile_zone_  = {.name = (zone_name)};              \
+            uint32_t              profile_start_ = profile_timestamp();                \
+            call;                                                                      \
+            profile_zone_record(&profile_zone_, profile_timestamp() - profile_start_); \
+        } while (0)
+#    define PROFILE_ZONE_EXPR(zone_name, expr)                                         \
+        ({                                                                             \
+            static profile_zone_t profile_zone_   = {.name = (zone_name)};             \
+            uint32_t              profile_start_  = profile_timestamp();               \
+            __typeof__(expr)      profile_result_ = (expr);                            \
+            profile_zone_record(&profile_zone_, profile_timestamp() - profile_start_); \
+            profile_result_;                                                           \
+        })
 #else
-#    error Unknown protocol in use
+#    define PROFILE_ZONE(zone_name, call) \
+        do {                              \
+            call;                         \
+        } while (0)
+#    define PROFILE_ZONE_EXPR(zone_name, expr) (expr)
 #endif
 
 #ifndef CONSOLE_ENABLE
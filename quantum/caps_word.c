@@ -40,8 +40,20 @@ void caps_word_task(void) {
 void caps_word_reset_idle_timer(void) {
     idle_timer = timer_read() + CAPS_WORD_IDLE_TIMEOUT;
 }
+
+uint32_t caps_word_next_deadline(void) {
+    if (!caps_word_active) {
+        return TIMER_NO_DEADLINE;
+    }
+    uint16_t now = timer_read();
+    return timer_expired(now, idle_timer) ? 0 : (uint16_t)(idle_timer - now);
+}
 #else
 void caps_word_task(void) {}
+
+uint32_t caps_word_next_deadline(void) {
+    return TIMER_NO_DEADLINE;
+}
 #endif // CAPS_WORD_IDLE_TIMEOUT > 0
 
 void caps_word_on(void) {
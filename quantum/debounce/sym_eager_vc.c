@@ -0,0 +1,99 @@
+/*
+Copyright 2023 QMK
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+Per-key algorithm with vertical counters, behaving like sym_eager_pk.
+After pressing a key, it immediately changes state, and sets a counter.
+No further inputs are accepted until DEBOUNCE milliseconds have occurred.
+*/
+
+#include "debounce.h"
+#include "timer.h"
+#include <string.h>
+
+#ifndef DEBOUNCE
+#    define DEBOUNCE 5
+#endif
+
+// Maximum debounce: 255ms
+#if DEBOUNCE > UINT8_MAX
+#    undef DEBOUNCE
+#    define DEBOUNCE UINT8_MAX
+#endif
+
+#if DEBOUNCE > 0
+#    include "vertical_counter.h"
+
+static vertical_counter_t debounce_counters[MATRIX_ROWS];
+static fast_timer_t       last_time;
+static bool               counters_need_update;
+static bool               matrix_need_update;
+
+// we use num_rows rather than MATRIX_ROWS to support split keyboards
+void debounce_init(uint8_t num_rows) {
+    memset(debounce_counters, 0, sizeof(debounce_counters));
+    counters_need_update = false;
+    matrix_need_update   = false;
+}
+
+void debounce_free(void) {}
+
+bool debounce(matrix_row_t raw[], matrix_row_t cooked[], uint8_t num_rows, bool changed) {
+    bool updated_last   = false;
+    bool cooked_changed = false;
+
+    if (counters_need_update) {
+        fast_timer_t now          = timer_read_fast();
+        fast_timer_t elapsed_time = TIMER_DIFF_FAST(now, last_time);
+
+        last_time    = now;
+        updated_last = true;
+        if (elapsed_time > UINT8_MAX) {
+            elapsed_time = UINT8_MAX;
+        }
+
+        if (elapsed_time > 0) {
+            counters_need_update = false;
+            matrix_need_update   = false;
+            for (uint8_t row = 0; row < num_rows; row++) {
+                matrix_row_t running;
+                matrix_need_update |= vertical_counter_elapse(debounce_counters[row], elapsed_time, &running) != 0;
+                counters_need_update |= running != 0;
+            }
+        }
+    }
+
+    if (changed || matrix_need_update) {
+        if (!updated_last) {
+            last_time = timer_read_fast();
+        }
+
+        matrix_need_update = false;
+        for (uint8_t row = 0; row < num_rows; row++) {
+            matrix_row_t flipped = (raw[row] ^ cooked[row]) & ~vertical_counter_active(debounce_counters[row]);
+            if (flipped) {
+                vertical_counter_start(debounce_counters[row], flipped);
+                counters_need_update = true;
+                cooked[row] ^= flipped;
+                cooked_changed = true;
+            }
+        }
+    }
+
+    return cooked_changed;
+}
+
+#else
+#    include "none.c"
+#endif
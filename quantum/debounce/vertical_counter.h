@@ -0,0 +1,121 @@
+/*
+Copyright 2023 QMK
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+Vertical counters for the *_vc debounce algorithms.
+
+Bit n of a counter lives in plane n, and each plane holds that bit for every
+key of a row. A whole row of per-key counters is then loaded, compared and
+counted down with a handful of bitwise operations per plane instead of a loop
+over the columns. A counter of zero means the key is not debouncing.
+*/
+
+#pragma once
+
+#include "matrix.h"
+
+#if DEBOUNCE < 2
+#    define DEBOUNCE_PLANES 1
+#elif DEBOUNCE < 4
+#    define DEBOUNCE_PLANES 2
+#elif DEBOUNCE < 8
+#    define DEBOUNCE_PLANES 3
+#elif DEBOUNCE < 16
+#    define DEBOUNCE_PLANES 4
+#elif DEBOUNCE < 32
+#    define DEBOUNCE_PLANES 5
+#elif DEBOUNCE < 64
+#    define DEBOUNCE_PLANES 6
+#elif DEBOUNCE < 128
+#    define DEBOUNCE_PLANES 7
+#else
+#    define DEBOUNCE_PLANES 8
+#endif
+
+typedef matrix_row_t vertical_counter_t[DEBOUNCE_PLANES];
+
+// Keys whose counter is still running.
+static inline matrix_row_t vertical_counter_active(const vertical_counter_t counter) {
+    matrix_row_t active = 0;
+    for (uint8_t plane = 0; plane < DEBOUNCE_PLANES; plane++) {
+        active |= counter[plane];
+    }
+    return active;
+}
+
+// Sets the counters of the `keys` to DEBOUNCE.
+static inline void vertical_counter_start(vertical_counter_t counter, matrix_row_t keys) {
+    for (uint8_t plane = 0; plane < DEBOUNCE_PLANES; plane++) {
+        counter[plane] = (DEBOUNCE >> plane) & 1 ? counter[plane] | keys : counter[plane] & ~keys;
+    }
+}
+
+// Stops the counters of the `keys`.
+static inline void vertical_counter_clear(vertical_counter_t counter, matrix_row_t keys) {
+    for (uint8_t plane = 0; plane < DEBOUNCE_PLANES; plane++) {
+        counter[plane] &= ~keys;
+    }
+}
+
+// Counts every running counter down by `elapsed`, stopping those that reach
+// zero. Returns the keys whose counter expired and stores the keys that are
+// still counting in `running`.
+static inline matrix_row_t vertical_counter_elapse(vertical_counter_t counter, uint8_t elapsed, matrix_row_t *running) {
+    matrix_row_t active = vertical_counter_active(counter);
+    if (elapsed >= DEBOUNCE) {
+        vertical_counter_clear(counter, active);
+        *running = 0;
+        return active;
+    }
+
+    matrix_row_t expired;
+    if (elapsed == 1) {
+        // The common case of one scan per millisecond: counters at one expire
+        expired = active & counter[0];
+        for (uint8_t plane = 1; plane < DEBOUNCE_PLANES; plane++) {
+            expired &= ~counter[plane];
+        }
+    } else {
+        // Compare against `elapsed` from the top plane down
+        matrix_row_t less  = 0;
+        matrix_row_t equal = ~(matrix_row_t)0;
+        for (int8_t plane = DEBOUNCE_PLANES - 1; plane >= 0; plane--) {
+            if ((elapsed >> plane) & 1) {
+                less |= equal & ~counter[plane];
+                equal &= counter[plane];
+            } else {
+                equal &= ~counter[plane];
+            }
+        }
+        expired = active & (less | equal);
+    }
+
+    // Subtract `elapsed` from the counters that keep running
+    *running            = active & ~expired;
+    matrix_row_t borrow = 0;
+    for (uint8_t plane = 0; plane < DEBOUNCE_PLANES; plane++) {
+        matrix_row_t bit = counter[plane];
+        matrix_row_t difference;
+        if ((elapsed >> plane) & 1) {
+            difference = ~bit ^ borrow;
+            borrow     = ~bit | borrow;
+        } else {
+            difference = bit ^ borrow;
+            borrow     = ~bit & borrow;
+        }
+        counter[plane] = difference & *running;
+    }
+
+    return expired;
+}
@@ -32,7 +32,12 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "util.h"
 #include "sendchar.h"
 #include "eeconfig.h"
+#include "action.h"
 #include "action_layer.h"
+#include "action_tapping.h"
+#include "action_util.h"
+#include "basic_profiling.h"
+#include "task_scheduler.h"
 #ifdef AUDIO_ENABLE
 #    include "audio.h"
 #endif
@@ -75,6 +80,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifdef STENO_ENABLE
 #    include "process_steno.h"
 #endif
+#ifdef CONSOLE_TRACE_ENABLE
+#    include "console_trace.h"
+#endif
 #ifdef KEY_OVERRIDE_ENABLE
 #    include "process_key_override.h"
 #endif
@@ -473,6 +481,19 @@ void keyboard_init(void) {
  * This is differnet than keycode events as no layer processing, or filtering occurs.
  */
 void switch_events(uint8_t row, uint8_t col, bool pressed) {
+#if defined(THREADED_TASKS_ENABLE) && (defined(LED_MATRIX_ENABLE) || defined(RGB_MATRIX_ENABLE))
+    // The LED matrices belong to the render thread, hand the event over
+    threaded_tasks_post_switch_event(row, col, pressed);
+#else
+    keyboard_render_switch_event(row, col, pressed);
+#endif
+}
+
+/** \brief Feeds a switch event to the reactive LED effects.
+ *
+ * Called from switch_events(), or by the render thread with THREADED_TASKS_ENABLE.
+ */
+void keyboard_render_switch_event(uint8_t row, uint8_t col, bool pressed) {
 #if defined(LED_MATRIX_ENABLE)
     process_led_matrix(row, col, pressed);
 #endif
@@ -509,7 +530,7 @@ static bool matrix_task(void) {
 
     static matrix_row_t matrix_previous[MATRIX_ROWS];
 
-    matrix_scan();
+    PROFILE_ZONE("matrix_scan", matrix_scan());
     bool matrix_changed = false;
     for (uint8_t row = 0; row < MATRIX_ROWS && !matrix_changed; row++) {
         matrix_changed |= matrix_previous[row] ^ matrix_get_row(row);
@@ -543,7 +564,7 @@ static bool matrix_task(void) {
                 const bool key_pressed = current_row & col_mask;
 
                 if (process_keypress) {
-                    action_exec(MAKE_KEYEVENT(row, col, key_pressed));
+                    PROFILE_ZONE("action_exec", action_exec(MAKE_KEYEVENT(row, col, key_pressed)));
                 }
 
                 switch_events(row, col, key_pressed);
@@ -602,6 +623,10 @@ void quantum_task(void) {
     tap_dance_task();
 #endif
 
+#ifdef STENO_ENABLE
+    steno_task();
+#endif
+
 #ifdef COMBO_ENABLE
     combo_task();
 #endif
@@ -631,12 +656,58 @@ void quantum_task(void) {
 #endif
 }
 
-/** \brief Main task that is repeatedly called as fast as possible. */
+/** \brief LED matrix and display tasks.
+ *
+ * Called from keyboard_task(), or in a loop by a low priority thread with
+ * THREADED_TASKS_ENABLE so that rendering never delays a matrix scan.
+ */
+void keyboard_render_task(void) {
+#ifdef LED_MATRIX_ENABLE
+    SCHEDULED_TASK("led_matrix_task", LED_MATRIX_TASK_INTERVAL, PROFILE_ZONE("led_matrix_task", led_matrix_task()));
+#endif
+#ifdef RGB_MATRIX_ENABLE
+    SCHEDULED_TASK("rgb_matrix_task", RGB_MATRIX_TASK_INTERVAL, PROFILE_ZONE("rgb_matrix_task", rgb_matrix_task()));
+#endif
+
+#if (defined(OLED_ENABLE) && OLED_TIMEOUT > 0) || (defined(ST7565_ENABLE) && ST7565_TIMEOUT > 0)
+    // Compare timestamps rather than sharing a flag, as the scan may run in another thread
+    static uint32_t last_activity         = 0;
+    bool            activity_has_occurred = last_input_activity_time() != last_activity;
+    last_activity                         = last_input_activity_time();
+#endif
+
+#ifdef OLED_ENABLE
+    SCHEDULED_TASK("oled_task", OLED_TASK_INTERVAL, oled_task());
+#    if OLED_TIMEOUT > 0
+    // Wake up oled if user is using those fabulous keys or spinning those encoders!
+    if (activity_has_occurred) oled_on();
+#    endif
+#endif
+
+#ifdef ST7565_ENABLE
+    SCHEDULED_TASK("st7565_task", ST7565_TASK_INTERVAL, st7565_task());
+#    if ST7565_TIMEOUT > 0
+    // Wake up display if user is using those fabulous keys or spinning those encoders!
+    if (activity_has_occurred) st7565_on();
+#    endif
+#endif
+}
+
+/** \brief Main task that is repeatedly called as fast as possible.
+ *
+ * Everything that produces reports runs first. LED, display and logging
+ * tasks follow, and with TASK_SCHEDULER_ENABLE they are deferred to later
+ * loops once the frame budget is used up. With THREADED_TASKS_ENABLE the
+ * LED matrix and display tasks run in keyboard_render_task() on their own
+ * thread instead.
+ */
 void keyboard_task(void) {
-    __attribute__((unused)) bool activity_has_occurred = false;
+#ifdef TASK_SCHEDULER_ENABLE
+    task_scheduler_frame_start();
+#endif
+
     if (matrix_task()) {
         last_matrix_activity_trigger();
-        activity_has_occurred = true;
     }
 
     quantum_task();
@@ -645,53 +716,18 @@ void keyboard_task(void) {
     split_watchdog_task();
 #endif
 
-#if defined(RGBLIGHT_ENABLE)
-    rgblight_task();
-#endif
-
-#ifdef LED_MATRIX_ENABLE
-    led_matrix_task();
-#endif
-#ifdef RGB_MATRIX_ENABLE
-    rgb_matrix_task();
-#endif
-
-#if defined(BACKLIGHT_ENABLE)
-#    if defined(BACKLIGHT_PIN) || defined(BACKLIGHT_PINS)
-    backlight_task();
-#    endif
-#endif
-
 #ifdef ENCODER_ENABLE
     if (encoder_read()) {
         last_encoder_activity_trigger();
-        activity_has_occurred = true;
     }
 #endif
 
 #ifdef POINTING_DEVICE_ENABLE
     if (pointing_device_task()) {
         last_pointing_device_activity_trigger();
-        activity_has_occurred = true;
     }
 #endif
 
-#ifdef OLED_ENABLE
-    oled_task();
-#    if OLED_TIMEOUT > 0
-    // Wake up oled if user is using those fabulous keys or spinning those encoders!
-    if (activity_has_occurred) oled_on();
-#    endif
-#endif
-
-#ifdef ST7565_ENABLE
-    st7565_task();
-#    if ST7565_TIMEOUT > 0
-    // Wake up display if user is using those fabulous keys or spinning those encoders!
-    if (activity_has_occurred) st7565_on();
-#    endif
-#endif
-
 #ifdef MOUSEKEY_ENABLE
     // mousekey repeat & acceleration
     mousekey_task();
@@ -717,5 +753,95 @@ void keyboard_task(void) {
     haptic_task();
 #endif
 
+#if defined(BACKLIGHT_ENABLE)
+#    if defined(BACKLIGHT_PIN) || defined(BACKLIGHT_PINS)
+    backlight_task();
+#    endif
+#endif
+
+#if defined(RGBLIGHT_ENABLE)
+    SCHEDULED_TASK("rgblight_task", RGBLIGHT_TASK_INTERVAL, rgblight_task());
+#endif
+
+#ifdef THREADED_TASKS_ENABLE
+    // EEPROM is only written from this thread, the render thread leaves it to us
+#    ifdef LED_MATRIX_ENABLE
+    led_matrix_eeconfig_task();
+#    endif
+#    ifdef RGB_MATRIX_ENABLE
+    rgb_matrix_eeconfig_task();
+#    endif
+#else
+    keyboard_render_task();
+#endif
+
+#ifdef CONSOLE_TRACE_ENABLE
+    SCHEDULED_TASK("console_trace_task", CONSOLE_TRACE_TASK_INTERVAL, console_trace_task());
+#endif
+
+#ifdef PROFILE_ZONES_ENABLE
+    SCHEDULED_TASK("profile_zones_task", PROFILE_ZONES_TASK_INTERVAL, profile_zones_task());
+#endif
+
     led_task();
 }
+
+__attribute__((weak)) uint32_t keyboard_next_deadline_user(void) {
+    return TIMER_NO_DEADLINE;
+}
+
+__attribute__((weak)) uint32_t keyboard_next_deadline_kb(void) {
+    return keyboard_next_deadline_user();
+}
+
+/** \brief Milliseconds until keyboard_task() next has time based work to do.
+ *
+ * Collects the pending timeouts of tapping, one shot keys and the other
+ * features that only act once a timeout expires. Features that animate, poll
+ * or count loops on every pass have no such query, so this returns 0 while
+ * any of them is enabled. Returns TIMER_NO_DEADLINE if nothing is pending
+ * until the next input change.
+ */
+uint32_t keyboard_next_deadline(void) {
+#if defined(AUDIO_ENABLE) || defined(MIDI_ENABLE) || defined(SEQUENCER_ENABLE) || defined(MOUSEKEY_ENABLE) || defined(PS2_MOUSE_ENABLE) || defined(POINTING_DEVICE_ENABLE) || defined(JOYSTICK_ENABLE) || defined(WPM_ENABLE) || defined(HAPTIC_ENABLE) || defined(BACKLIGHT_ENABLE) || defined(RGBLIGHT_ENABLE) || defined(OLED_ENABLE) || defined(ST7565_ENABLE) || defined(BLUETOOTH_ENABLE) || defined(SPLIT_KEYBOARD) || defined(TASK_SCHEDULER_ENABLE) || defined(CONSOLE_TRACE_ENABLE) || defined(PROFILE_ZONES_ENABLE) || defined(DEBUG_MATRIX_SCAN_RATE)
+    return 0;
+#else
+    uint32_t deadline = keyboard_next_deadline_kb();
+
+#    ifndef NO_ACTION_TAPPING
+    deadline = MIN(deadline, action_tapping_next_deadline());
+#    endif
+#    ifndef NO_ACTION_ONESHOT
+    deadline = MIN(deadline, oneshot_next_deadline());
+#    endif
+#    ifdef KEY_OVERRIDE_ENABLE
+    deadline = MIN(deadline, key_override_next_deadline());
+#    endif
+#    ifdef TAP_DANCE_ENABLE
+    deadline = MIN(deadline, tap_dance_next_deadline());
+#    endif
+#    ifdef COMBO_ENABLE
+    deadline = MIN(deadline, combo_next_deadline());
+#    endif
+#    ifdef LEADER_ENABLE
+    deadline = MIN(deadline, leader_next_deadline());
+#    endif
+#    ifdef AUTO_SHIFT_ENABLE
+    deadline = MIN(deadline, autoshift_next_deadline());
+#    endif
+#    ifdef CAPS_WORD_ENABLE
+    deadline = MIN(deadline, caps_word_next_deadline());
+#    endif
+#    ifdef SECURE_ENABLE
+    deadline = MIN(deadline, secure_next_deadline());
+#    endif
+#    if defined(LED_MATRIX_ENABLE) && !defined(THREADED_TASKS_ENABLE)
+    deadline = MIN(deadline, led_matrix_next_deadline());
+#    endif
+#    if defined(RGB_MATRIX_ENABLE) && !defined(THREADED_TASKS_ENABLE)
+    deadline = MIN(deadline, rgb_matrix_next_deadline());
+#    endif
+
+    return deadline;
+#endif
+}
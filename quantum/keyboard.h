@@ -98,6 +98,24 @@ void keyboard_setup(void);
 void keyboard_init(void);
 /* it runs repeatedly in main loop */
 void keyboard_task(void);
+/* it returns the milliseconds until keyboard_task has time based work, or TIMER_NO_DEADLINE */
+uint32_t keyboard_next_deadline(void);
+uint32_t keyboard_next_deadline_kb(void);
+uint32_t keyboard_next_deadline_user(void);
+/* it runs the LED matrix and display tasks, from keyboard_task or the render thread */
+void keyboard_render_task(void);
+/* it feeds switch events to the reactive LED effects, from switch_events or the render thread */
+void keyboard_render_switch_event(uint8_t row, uint8_t col, bool pressed);
+#ifdef THREADED_TASKS_ENABLE
+/* it hands a switch event over to the render thread, implemented by the protocol */
+void threaded_tasks_post_switch_event(uint8_t row, uint8_t col, bool pressed);
+/* it keeps the render thread out while the main thread changes lighting or display state, calls may nest */
+void threaded_tasks_lock(void);
+void threaded_tasks_unlock(void);
+#else
+static inline void threaded_tasks_lock(void) {}
+static inline void threaded_tasks_unlock(void) {}
+#endif
 /* it runs whenever code has to behave differently on a slave */
 bool is_keyboard_master(void);
 /* it runs whenever code has to behave differently on left vs right split */
@@ -43,6 +43,18 @@ void leader_task(void) {
     }
 }
 
+uint32_t leader_next_deadline(void) {
+#if defined(LEADER_NO_TIMEOUT)
+    if (!leader_sequence_active() || leader_sequence_size == 0) {
+#else
+    if (!leader_sequence_active()) {
+#endif
+        return TIMER_NO_DEADLINE;
+    }
+    uint16_t elapsed = timer_elapsed(leader_time);
+    return elapsed > LEADER_TIMEOUT ? 0 : LEADER_TIMEOUT + 1 - elapsed;
+}
+
 bool leader_sequence_active(void) {
     return leading;
 }
@@ -33,6 +33,11 @@ void leader_end(void);
 
 void leader_task(void);
 
+/**
+ * Milliseconds until the leader sequence times out, or TIMER_NO_DEADLINE.
+ */
+uint32_t leader_next_deadline(void);
+
 /**
  * Whether the leader sequence is active.
  */
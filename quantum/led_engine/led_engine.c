@@ -0,0 +1,177 @@
+// Copyright 2023 QMK
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include <string.h>
+#include "led_engine.h"
+#include "sync_timer.h"
+
+#ifdef LED_ENGINE_KEYREACTIVE_ENABLED
+last_hit_t g_last_hit_tracker;
+
+static void led_engine_clear_hits(last_hit_t *hits) {
+    hits->count = 0;
+    for (uint8_t i = 0; i < LED_HITS_TO_REMEMBER; ++i) {
+        hits->tick[i] = UINT16_MAX;
+    }
+}
+#endif // LED_ENGINE_KEYREACTIVE_ENABLED
+
+void led_engine_init(led_engine_t *engine, const led_engine_vtable_t *vtable, uint32_t timeout) {
+    engine->vtable       = vtable;
+    engine->state        = SYNCING;
+    engine->params       = (effect_params_t){0, LED_FLAG_ALL, false};
+    engine->config       = (led_engine_config_t){0, 0, LED_FLAG_ALL};
+    engine->last_enable  = UINT8_MAX;
+    engine->last_effect  = UINT8_MAX;
+    engine->suspended    = false;
+    engine->timer_buffer = sync_timer_read32();
+    engine->anykey_timer = 0;
+    engine->timeout      = timeout;
+
+#ifdef LED_ENGINE_KEYREACTIVE_ENABLED
+    led_engine_clear_hits(&g_last_hit_tracker);
+    led_engine_clear_hits(&engine->hit_buffer);
+#endif // LED_ENGINE_KEYREACTIVE_ENABLED
+}
+
+void led_engine_add_hits(led_engine_t *engine, const led_point_t *points, const uint8_t *leds, uint8_t count) {
+#ifdef LED_ENGINE_KEYREACTIVE_ENABLED
+    last_hit_t *hits = &engine->hit_buffer;
+
+    if (hits->count + count > LED_HITS_TO_REMEMBER) {
+        memcpy(&hits->x[0], &hits->x[count], LED_HITS_TO_REMEMBER - count);
+        memcpy(&hits->y[0], &hits->y[count], LED_HITS_TO_REMEMBER - count);
+        memcpy(&hits->tick[0], &hits->tick[count], (LED_HITS_TO_REMEMBER - count) * 2); // 16 bit
+        memcpy(&hits->index[0], &hits->index[count], LED_HITS_TO_REMEMBER - count);
+        hits->count = LED_HITS_TO_REMEMBER - count;
+    }
+
+    for (uint8_t i = 0; i < count; i++) {
+        uint8_t index      = hits->count;
+        hits->x[index]     = points[leds[i]].x;
+        hits->y[index]     = points[leds[i]].y;
+        hits->index[index] = leds[i];
+        hits->tick[index]  = 0;
+        hits->count++;
+    }
+#endif // LED_ENGINE_KEYREACTIVE_ENABLED
+}
+
+static void led_engine_timers(led_engine_t *engine) {
+    uint32_t deltaTime   = sync_timer_elapsed32(engine->timer_buffer);
+    engine->timer_buffer = sync_timer_read32();
+
+    // Update double buffer timers
+    if (UINT32_MAX - deltaTime < engine->anykey_timer) {
+        engine->anykey_timer = UINT32_MAX;
+    } else {
+        engine->anykey_timer += deltaTime;
+    }
+
+    // Update double buffer last hit timers
+#ifdef LED_ENGINE_KEYREACTIVE_ENABLED
+    uint8_t count = engine->hit_buffer.count;
+    for (uint8_t i = 0; i < count; ++i) {
+        if (UINT16_MAX - deltaTime < engine->hit_buffer.tick[i]) {
+            engine->hit_buffer.count--;
+            continue;
+        }
+        engine->hit_buffer.tick[i] += deltaTime;
+    }
+#endif // LED_ENGINE_KEYREACTIVE_ENABLED
+}
+
+static void led_engine_sync(led_engine_t *engine) {
+    engine->vtable->sync();
+    // next task
+    if (sync_timer_elapsed32(*engine->vtable->timer) >= engine->vtable->flush_limit) engine->state = STARTING;
+}
+
+static void led_engine_start(led_engine_t *engine, led_engine_config_t config) {
+    // reset iter
+    engine->params.iter = 0;
+
+    // update double buffers, the config may change at any time with threaded tasks
+    engine->config         = config;
+    *engine->vtable->timer = engine->timer_buffer;
+#ifdef LED_ENGINE_KEYREACTIVE_ENABLED
+    g_last_hit_tracker = engine->hit_buffer;
+#endif // LED_ENGINE_KEYREACTIVE_ENABLED
+
+    // next task
+    engine->state = RENDERING;
+}
+
+void led_engine_render(led_engine_t *engine, led_engine_config_t config, uint8_t effect) {
+    engine->params.init = (effect != engine->last_effect) || (config.enable != engine->last_enable);
+    if (engine->params.flags != config.flags) {
+        engine->params.flags = config.flags;
+        engine->vtable->clear();
+    }
+
+    // each effect can opt to do calculations
+    // and/or request PWM buffer updates.
+    bool rendering = engine->vtable->render(effect, &engine->params);
+
+    engine->params.iter++;
+
+    // next task
+    if (!rendering) {
+        engine->state = FLUSHING;
+        if (!engine->params.init && effect == 0) {
+            // We only need to flush once if there is no effect
+            engine->state = SYNCING;
+        }
+    }
+}
+
+void led_engine_flush(led_engine_t *engine, led_engine_config_t config, uint8_t effect) {
+    // update last trackers after the first full render so we can init over several frames
+    engine->last_effect = effect;
+    engine->last_enable = config.enable;
+
+    engine->vtable->flush(effect);
+
+    // next task
+    engine->state = SYNCING;
+}
+
+// Only the wait for the frame limit can be skipped, every other state has work to do
+uint32_t led_engine_next_deadline(const led_engine_t *engine) {
+    if (engine->state != SYNCING) {
+        return 0;
+    }
+    uint32_t elapsed = sync_timer_elapsed32(*engine->vtable->timer);
+    return elapsed >= engine->vtable->flush_limit ? 0 : engine->vtable->flush_limit - elapsed;
+}
+
+void led_engine_task(led_engine_t *engine, led_engine_config_t config) {
+    led_engine_timers(engine);
+
+    // Ideally we would also stop sending zeros to the LED driver PWM buffers
+    // while suspended and just do a software shutdown. This is a cheap hack for now.
+    bool suspend_backlight = engine->suspended || led_engine_timed_out(engine);
+
+    uint8_t effect = suspend_backlight || !engine->config.enable ? 0 : engine->config.mode;
+
+    switch (engine->state) {
+        case STARTING:
+            led_engine_start(engine, config);
+            break;
+        case RENDERING:
+            led_engine_render(engine, engine->config, effect);
+            if (effect) {
+                if (engine->state == FLUSHING) { // ensure we only draw basic indicators once rendering is finished
+                    engine->vtable->indicators();
+                }
+                engine->vtable->indicators_advanced(&engine->params);
+            }
+            break;
+        case FLUSHING:
+            led_engine_flush(engine, engine->config, effect);
+            break;
+        case SYNCING:
+            led_engine_sync(engine);
+            break;
+    }
+}
@@ -0,0 +1,75 @@
+// Copyright 2023 QMK
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "led_engine_types.h"
+
+/* The task state machine, key hit tracking and timeout handling shared by
+ * LED Matrix and RGB Matrix. Each matrix owns its effects, eeconfig and driver
+ * and plugs them into the engine through a vtable:
+ *
+ *   SYNCING   - flush eeconfig and wait for the frame limit
+ *   STARTING  - latch the config, timers and hits the effects will see this frame
+ *   RENDERING - call the effect until it has drawn every chunk of LEDs
+ *   FLUSHING  - send the frame to the driver
+ */
+
+typedef struct {
+    void (*sync)(void);
+    bool (*render)(uint8_t effect, effect_params_t *params);
+    void (*clear)(void);
+    void (*flush)(uint8_t effect);
+    void (*indicators)(void);
+    void (*indicators_advanced)(effect_params_t *params);
+    uint32_t *timer;
+    uint16_t  flush_limit;
+} led_engine_vtable_t;
+
+typedef struct {
+    uint8_t     enable;
+    uint8_t     mode;
+    led_flags_t flags;
+} led_engine_config_t;
+
+typedef struct {
+    const led_engine_vtable_t *vtable;
+    led_task_states            state;
+    effect_params_t            params;
+    led_engine_config_t        config;
+    uint8_t                    last_enable;
+    uint8_t                    last_effect;
+    bool                       suspended;
+    uint32_t                   timer_buffer;
+    uint32_t                   anykey_timer;
+    uint32_t                   timeout;
+#ifdef LED_ENGINE_KEYREACTIVE_ENABLED
+    last_hit_t hit_buffer;
+#endif // LED_ENGINE_KEYREACTIVE_ENABLED
+} led_engine_t;
+
+#ifdef LED_ENGINE_KEYREACTIVE_ENABLED
+extern last_hit_t g_last_hit_tracker;
+#endif // LED_ENGINE_KEYREACTIVE_ENABLED
+
+void led_engine_init(led_engine_t *engine, const led_engine_vtable_t *vtable, uint32_t timeout);
+void led_engine_add_hits(led_engine_t *engine, const led_point_t *points, const uint8_t *leds, uint8_t count);
+void led_engine_task(led_engine_t *engine, led_engine_config_t config);
+void led_engine_render(led_engine_t *engine, led_engine_config_t config, uint8_t effect);
+void led_engine_flush(led_engine_t *engine, led_engine_config_t config, uint8_t effect);
+uint32_t led_engine_next_deadline(const led_engine_t *engine);
+
+static inline void led_engine_restart(led_engine_t *engine) {
+    engine->state = STARTING;
+}
+
+static inline void led_engine_reset_timeout(led_engine_t *engine) {
+    engine->anykey_timer = 0;
+}
+
+// A timeout of zero never expires
+static inline bool led_engine_timed_out(const led_engine_t *engine) {
+    return engine->timeout && engine->anykey_timer > engine->timeout;
+}
@@ -18,6 +18,7 @@
  */
 
 #include "led_matrix.h"
+#include "led_engine.h"
 #include "progmem.h"
 #include "eeprom.h"
 #include "eeconfig.h"
@@ -67,29 +68,12 @@ uint32_t       g_led_timer;
 #ifdef LED_MATRIX_FRAMEBUFFER_EFFECTS
 uint8_t g_led_frame_buffer[MATRIX_ROWS][MATRIX_COLS] = {{0}};
 #endif // LED_MATRIX_FRAMEBUFFER_EFFECTS
-#ifdef LED_MATRIX_KEYREACTIVE_ENABLED
-last_hit_t g_last_hit_tracker;
-#endif // LED_MATRIX_KEYREACTIVE_ENABLED
 
 // internals
 #ifdef LED_MATRIX_DRIVER_SHUTDOWN_ENABLE
 static bool driver_shutdown = false;
 #endif
-static bool            suspend_state     = false;
-static uint8_t         led_last_enable   = UINT8_MAX;
-static uint8_t         led_last_effect   = UINT8_MAX;
-static effect_params_t led_effect_params = {0, LED_FLAG_ALL, false};
-static led_task_states led_task_state    = SYNCING;
-#if LED_MATRIX_TIMEOUT > 0
-static uint32_t led_anykey_timer;
-static uint32_t led_matrix_timeout = LED_MATRIX_TIMEOUT;
-#endif // LED_MATRIX_TIMEOUT > 0
-
-// double buffers
-static uint32_t led_timer_buffer;
-#ifdef LED_MATRIX_KEYREACTIVE_ENABLED
-static last_hit_t last_hit_buffer;
-#endif // LED_MATRIX_KEYREACTIVE_ENABLED
+static led_engine_t led_matrix_engine;
 
 // split led matrix
 #if defined(LED_MATRIX_ENABLE) && defined(LED_MATRIX_SPLIT)
@@ -165,9 +149,7 @@ void process_led_matrix(uint8_t row, uint8_t col, bool pressed) {
 #ifndef LED_MATRIX_SPLIT
     if (!is_keyboard_master()) return;
 #endif
-#if LED_MATRIX_TIMEOUT > 0
-    led_anykey_timer = 0;
-#endif // LED_MATRIX_TIMEOUT > 0
+    led_engine_reset_timeout(&led_matrix_engine);
 
 #ifdef LED_MATRIX_KEYREACTIVE_ENABLED
     uint8_t led[LED_HITS_TO_REMEMBER];
@@ -182,22 +164,7 @@ void process_led_matrix(uint8_t row, uint8_t col, bool pressed) {
         led_count = led_matrix_map_row_column_to_led(row, col, led);
     }
 
-    if (last_hit_buffer.count + led_count > LED_HITS_TO_REMEMBER) {
-        memcpy(&last_hit_buffer.x[0], &last_hit_buffer.x[led_count], LED_HITS_TO_REMEMBER - led_count);
-        memcpy(&last_hit_buffer.y[0], &last_hit_buffer.y[led_count], LED_HITS_TO_REMEMBER - led_count);
-        memcpy(&last_hit_buffer.tick[0], &last_hit_buffer.tick[led_count], (LED_HITS_TO_REMEMBER - led_count) * 2); // 16 bit
-        memcpy(&last_hit_buffer.index[0], &last_hit_buffer.index[led_count], LED_HITS_TO_REMEMBER - led_count);
-        last_hit_buffer.count = LED_HITS_TO_REMEMBER - led_count;
-    }
-
-    for (uint8_t i = 0; i < led_count; i++) {
-        uint8_t index                = last_hit_buffer.count;
-        last_hit_buffer.x[index]     = g_led_config.point[led[i]].x;
-        last_hit_buffer.y[index]     = g_led_config.point[led[i]].y;
-        last_hit_buffer.index[index] = led[i];
-        last_hit_buffer.tick[index]  = 0;
-        last_hit_buffer.count++;
-    }
+    led_engine_add_hits(&led_matrix_engine, g_led_config.point, led, led_count);
 #endif // LED_MATRIX_KEYREACTIVE_ENABLED
 
 #if defined(LED_MATRIX_FRAMEBUFFER_EFFECTS) && defined(ENABLE_LED_MATRIX_TYPING_HEATMAP)
@@ -226,84 +193,39 @@ static bool led_matrix_none(effect_params_t *params) {
     return false;
 }
 
-static void led_task_timers(void) {
-#if defined(LED_MATRIX_KEYREACTIVE_ENABLED) || LED_MATRIX_TIMEOUT > 0
-    uint32_t deltaTime = sync_timer_elapsed32(led_timer_buffer);
-#endif // defined(LED_MATRIX_KEYREACTIVE_ENABLED) || LED_MATRIX_TIMEOUT > 0
-    led_timer_buffer = sync_timer_read32();
-
-    // Update double buffer timers
-#if LED_MATRIX_TIMEOUT > 0
-    if (led_anykey_timer < UINT32_MAX) {
-        if (UINT32_MAX - deltaTime < led_anykey_timer) {
-            led_anykey_timer = UINT32_MAX;
-        } else {
-            led_anykey_timer += deltaTime;
-        }
-    }
-#endif // LED_MATRIX_TIMEOUT > 0
-
-    // Update double buffer last hit timers
-#ifdef LED_MATRIX_KEYREACTIVE_ENABLED
-    uint8_t count = last_hit_buffer.count;
-    for (uint8_t i = 0; i < count; ++i) {
-        if (UINT16_MAX - deltaTime < last_hit_buffer.tick[i]) {
-            last_hit_buffer.count--;
-            continue;
-        }
-        last_hit_buffer.tick[i] += deltaTime;
-    }
-#endif // LED_MATRIX_KEYREACTIVE_ENABLED
-}
-
-static void led_task_sync(void) {
+static void led_matrix_engine_sync(void) {
+#ifndef THREADED_TASKS_ENABLE
     eeconfig_flush_led_matrix(false);
-    // next task
-    if (sync_timer_elapsed32(g_led_timer) >= LED_MATRIX_LED_FLUSH_LIMIT) led_task_state = STARTING;
+#endif
 }
 
-static void led_task_start(void) {
-    // reset iter
-    led_effect_params.iter = 0;
-
-    // update double buffers
-    g_led_timer = led_timer_buffer;
-#ifdef LED_MATRIX_KEYREACTIVE_ENABLED
-    g_last_hit_tracker = last_hit_buffer;
-#endif // LED_MATRIX_KEYREACTIVE_ENABLED
-
-    // next task
-    led_task_state = RENDERING;
+static void led_matrix_engine_clear(void) {
+    led_matrix_set_value_all(0);
 }
 
-static void led_task_render(uint8_t effect) {
-    bool rendering         = false;
-    led_effect_params.init = (effect != led_last_effect) || (led_matrix_eeconfig.enable != led_last_enable);
-    if (led_effect_params.flags != led_matrix_eeconfig.flags) {
-        led_effect_params.flags = led_matrix_eeconfig.flags;
-        led_matrix_set_value_all(0);
-    }
+static bool led_matrix_engine_render(uint8_t effect, effect_params_t *params) {
+    bool rendering = false;
 
     // each effect can opt to do calculations
     // and/or request PWM buffer updates.
     switch (effect) {
         case LED_MATRIX_NONE:
-            rendering = led_matrix_none(&led_effect_params);
+            rendering = led_matrix_none(params);
             break;
 
 // ---------------------------------------------
 // -----Begin led effect switch case macros-----
-#define LED_MATRIX_EFFECT(name, ...)          \
-    case LED_MATRIX_##name:                   \
-        rendering = name(&led_effect_params); \
+#define LED_MATRIX_EFFECT(name, ...) \
+    case LED_MATRIX_##name:          \
+        rendering = name(params);    \
         break;
 #include "led_matrix_effects.inc"
 #undef LED_MATRIX_EFFECT
 
 #if defined(LED_MATRIX_CUSTOM_KB) || defined(LED_MATRIX_CUSTOM_USER)
-#    define LED_MATRIX_EFFECT(name, ...)          \
-        case LED_MATRIX_CUSTOM_##name:            \
-            rendering = name(&led_effect_params); \
+#    define LED_MATRIX_EFFECT(name, ...) \
+        case LED_MATRIX_CUSTOM_##name:   \
+            rendering = name(params);    \
             break;
 #    ifdef LED_MATRIX_CUSTOM_KB
 #        include "led_matrix_kb.inc"
@@ -317,22 +239,10 @@ static void led_task_render(uint8_t effect) {
             // ---------------------------------------------
     }
 
-    led_effect_params.iter++;
-
-    // next task
-    if (!rendering) {
-        led_task_state = FLUSHING;
-        if (!led_effect_params.init && effect == LED_MATRIX_NONE) {
-            // We only need to flush once if we are LED_MATRIX_NONE
-            led_task_state = SYNCING;
-        }
-    }
+    return rendering;
 }
 
-static void led_task_flush(uint8_t effect) {
-    // update last trackers after the first full render so we can init over several frames
-    led_last_effect = effect;
-    led_last_enable = led_matrix_eeconfig.enable;
+static void led_matrix_engine_flush(uint8_t effect) {
 #ifdef LED_MATRIX_DRIVER_SHUTDOWN_ENABLE
     // exit from shutdown to if neccesary
     if (driver_shutdown) {
@@ -349,44 +259,33 @@ static void led_task_flush(uint8_t effect) {
         led_matrix_driver_shutdown();
     }
 #endif
+}
 
-    // next task
-    led_task_state = SYNCING;
+static const led_engine_vtable_t led_matrix_engine_vtable = {
+    .sync                = led_matrix_engine_sync,
+    .render              = led_matrix_engine_render,
+    .clear               = led_matrix_engine_clear,
+    .flush               = led_matrix_engine_flush,
+    .indicators          = led_matrix_indicators,
+    .indicators_advanced = led_matrix_indicators_advanced,
+    .timer               = &g_led_timer,
+    .flush_limit         = LED_MATRIX_LED_FLUSH_LIMIT,
+};
+
+static led_engine_config_t led_matrix_engine_config(void) {
+    return (led_engine_config_t){led_matrix_eeconfig.enable, led_matrix_eeconfig.mode, led_matrix_eeconfig.flags};
 }
 
 void led_matrix_task(void) {
-    led_task_timers();
-
-    // Ideally we would also stop sending zeros to the LED driver PWM buffers
-    // while suspended and just do a software shutdown. This is a cheap hack for now.
-    bool suspend_backlight = suspend_state ||
-#if LED_MATRIX_TIMEOUT > 0
-                             (led_anykey_timer > led_matrix_timeout) ||
-#endif // led_matrix_timeout > 0
-                             false;
+    led_engine_task(&led_matrix_engine, led_matrix_engine_config());
+}
 
-    uint8_t effect = suspend_backlight || !led_matrix_eeconfig.enable ? 0 : led_matrix_eeconfig.mode;
+uint32_t led_matrix_next_deadline(void) {
+    return led_engine_next_deadline(&led_matrix_engine);
+}
 
-    switch (led_task_state) {
-        case STARTING:
-            led_task_start();
-            break;
-        case RENDERING:
-            led_task_render(effect);
-            if (effect) {
-                if (led_task_state == FLUSHING) {
-                    led_matrix_indicators(); // ensure we only draw basic indicators once rendering is finished
-                }
-                led_matrix_indicators_advanced(&led_effect_params);
-            }
-            break;
-        case FLUSHING:
-            led_task_flush(effect);
-            break;
-        case SYNCING:
-            led_task_sync();
-            break;
-    }
+void led_matrix_eeconfig_task(void) {
+    eeconfig_flush_led_matrix(false);
 }
 
 void led_matrix_indicators(void) {
@@ -403,9 +302,9 @@ __attribute__((weak)) bool led_matrix_indicators_user(void) {
 
 void led_matrix_indicators_advanced(effect_params_t *params) {
     /* special handling is needed for "params->iter", since it's already been incremented.
-     * Could move the invocations to led_task_render, but then it's missing a few checks
+     * Could move the invocations to led_engine_render, but then it's missing a few checks
      * and not sure which would be better. Otherwise, this should be called from
-     * led_task_render, right before the iter++ line.
+     * led_engine_render, right before the iter++ line.
      */
     LED_MATRIX_USE_LIMITS_ITER(min, max, params->iter - 1);
     led_matrix_indicators_advanced_kb(min, max);
@@ -452,17 +351,7 @@ struct led_matrix_limits_t led_matrix_get_limits(uint8_t iter) {
 void led_matrix_init(void) {
     led_matrix_driver.init();
 
-#ifdef LED_MATRIX_KEYREACTIVE_ENABLED
-    g_last_hit_tracker.count = 0;
-    for (uint8_t i = 0; i < LED_HITS_TO_REMEMBER; ++i) {
-        g_last_hit_tracker.tick[i] = UINT16_MAX;
-    }
-
-    last_hit_buffer.count = 0;
-    for (uint8_t i = 0; i < LED_HITS_TO_REMEMBER; ++i) {
-        last_hit_buffer.tick[i] = UINT16_MAX;
-    }
-#endif // LED_MATRIX_KEYREACTIVE_ENABLED
+    led_engine_init(&led_matrix_engine, &led_matrix_engine_vtable, LED_MATRIX_TIMEOUT);
 
     if (!eeconfig_is_enabled()) {
         dprintf("led_matrix_init_drivers eeconfig is not enabled.\n");
@@ -480,21 +369,21 @@ void led_matrix_init(void) {
 
 void led_matrix_set_suspend_state(bool state) {
 #ifdef LED_DISABLE_WHEN_USB_SUSPENDED
-    if (state && !suspend_state && is_keyboard_master()) { // only run if turning off, and only once
-        led_task_render(0);                                // turn off all LEDs when suspending
-        led_task_flush(0);                                 // and actually flash led state to LEDs
+    if (state && !led_matrix_engine.suspended && is_keyboard_master()) {      // only run if turning off, and only once
+        led_engine_render(&led_matrix_engine, led_matrix_engine_config(), 0); // turn off all LEDs when suspending
+        led_engine_flush(&led_matrix_engine, led_matrix_engine_config(), 0);  // and actually flash led state to LEDs
     }
-    suspend_state = state;
+    led_matrix_engine.suspended = state;
 #endif
 }
 
 bool led_matrix_get_suspend_state(void) {
-    return suspend_state;
+    return led_matrix_engine.suspended;
 }
 
 void led_matrix_toggle_eeprom_helper(bool write_to_eeprom) {
     led_matrix_eeconfig.enable ^= 1;
-    led_task_state = STARTING;
+    led_engine_restart(&led_matrix_engine);
     eeconfig_flag_led_matrix(write_to_eeprom);
     dprintf("led matrix toggle [%s]: led_matrix_eeconfig.enable = %u\n", (write_to_eeprom) ? "EEPROM" : "NOEEPROM", led_matrix_eeconfig.enable);
 #ifdef LED_MATRIX_BRIGHTNESS_TURN_OFF_VAL
@@ -521,7 +410,7 @@ void led_matrix_enable(void) {
 }
 
 void led_matrix_enable_noeeprom(void) {
-    if (!led_matrix_eeconfig.enable) led_task_state = STARTING;
+    if (!led_matrix_eeconfig.enable) led_engine_restart(&led_matrix_engine);
     led_matrix_eeconfig.enable = 1;
 #ifdef LED_MATRIX_BRIGHTNESS_TURN_OFF_VAL
     while (led_matrix_eeconfig.val <= LED_MATRIX_BRIGHTNESS_TURN_OFF_VAL) {
@@ -536,7 +425,7 @@ void led_matrix_disable(void) {
 }
 
 void led_matrix_disable_noeeprom(void) {
-    if (led_matrix_eeconfig.enable) led_task_state = STARTING;
+    if (led_matrix_eeconfig.enable) led_engine_restart(&led_matrix_engine);
     led_matrix_eeconfig.enable = 0;
 }
 
@@ -555,7 +444,7 @@ void led_matrix_mode_eeprom_helper(uint8_t mode, bool write_to_eeprom) {
     } else {
         led_matrix_eeconfig.mode = mode;
     }
-    led_task_state = STARTING;
+    led_engine_restart(&led_matrix_engine);
     eeconfig_flag_led_matrix(write_to_eeprom);
     dprintf("led matrix mode [%s]: %u\n", (write_to_eeprom) ? "EEPROM" : "NOEEPROM", led_matrix_eeconfig.mode);
 }
@@ -698,14 +587,14 @@ void led_matrix_set_flags_noeeprom(led_flags_t flags) {
 
 #if LED_MATRIX_TIMEOUT > 0
 void led_matrix_disable_timeout_set(uint32_t timeout) {
-    led_matrix_timeout = timeout;
+    led_matrix_engine.timeout = timeout;
 }
 void led_matrix_disable_time_reset(void) {
-    led_anykey_timer = 0;
+    led_engine_reset_timeout(&led_matrix_engine);
 }
 
 bool led_matrix_timeouted(void) {
-    return led_anykey_timer > led_matrix_timeout;
+    return led_engine_timed_out(&led_matrix_engine);
 }
 #endif
 
@@ -152,6 +152,13 @@ void process_led_matrix(uint8_t row, uint8_t col, bool pressed);
 
 void led_matrix_task(void);
 
+// Milliseconds until led_matrix_task() has work to do again
+uint32_t led_matrix_next_deadline(void);
+
+// Writes pending config changes to EEPROM, done by the engine sync unless
+// THREADED_TASKS_ENABLE moves the task off the main thread
+void led_matrix_eeconfig_task(void);
+
 void led_matrix_none_indicators_kb(void);
 void led_matrix_none_indicators_user(void);
 
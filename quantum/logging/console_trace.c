@@ -0,0 +1,110 @@
+// Copyright 2023 QMK
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include <string.h>
+#include "console_trace.h"
+#include "sendchar.h"
+#include "timer.h"
+
+#if (CONSOLE_TRACE_BUFFER_SIZE & (CONSOLE_TRACE_BUFFER_SIZE - 1)) != 0 || CONSOLE_TRACE_BUFFER_SIZE > 32768
+#    error CONSOLE_TRACE_BUFFER_SIZE must be a power of two no larger than 32768
+#endif
+
+#define TRACE_MASK (CONSOLE_TRACE_BUFFER_SIZE - 1)
+#define TRACE_HEADER_SIZE (sizeof(uintptr_t) + sizeof(uint16_t))
+#define TRACE_RECORD_SIZE (TRACE_HEADER_SIZE + CONSOLE_TRACE_MAX_ARGS * sizeof(uint32_t))
+
+// Frames start with an ASCII record separator, which never appears in text
+// output, and end with the zero byte the COBS encoding keeps out of the record.
+#define TRACE_FRAME_START 0x1E
+#define TRACE_FRAME_END 0x00
+
+// Each record is stored as its length followed by the record itself
+static uint8_t  trace_buffer[CONSOLE_TRACE_BUFFER_SIZE];
+static uint16_t trace_head = 0;
+static uint16_t trace_tail = 0;
+static uint16_t trace_dropped = 0;
+
+static inline void trace_put(const void *data, uint8_t length) {
+    const uint8_t *bytes = data;
+    for (uint8_t i = 0; i < length; i++) {
+        trace_buffer[trace_head++ & TRACE_MASK] = bytes[i];
+    }
+}
+
+void console_trace_record(const char *fmt, const uint32_t *args, uint8_t count) {
+    if (count > CONSOLE_TRACE_MAX_ARGS) {
+        count = CONSOLE_TRACE_MAX_ARGS;
+    }
+
+    uint8_t length = TRACE_HEADER_SIZE + count * sizeof(uint32_t);
+    if ((uint16_t)(trace_head - trace_tail) + length + 1 > CONSOLE_TRACE_BUFFER_SIZE) {
+        trace_dropped++;
+        return;
+    }
+
+    uintptr_t id   = (uintptr_t)fmt;
+    uint16_t  time = timer_read();
+    trace_buffer[trace_head++ & TRACE_MASK] = length;
+    trace_put(&id, sizeof(id));
+    trace_put(&time, sizeof(time));
+    trace_put(args, count * sizeof(uint32_t));
+}
+
+__attribute__((weak)) bool console_trace_send(const uint8_t *data, uint8_t length) {
+    for (uint8_t i = 0; i < length; i++) {
+        sendchar(data[i]);
+    }
+    return true;
+}
+
+static bool trace_send_frame(const uint8_t *record, uint8_t length) {
+    uint8_t frame[TRACE_RECORD_SIZE + 3];
+    uint8_t code_index = 1;
+    uint8_t size       = 2;
+
+    // COBS: each code byte holds the distance to the next zero
+    frame[0] = TRACE_FRAME_START;
+    for (uint8_t i = 0; i < length; i++) {
+        if (record[i] == 0) {
+            frame[code_index] = size - code_index;
+            code_index        = size++;
+        } else {
+            frame[size++] = record[i];
+        }
+    }
+    frame[code_index] = size - code_index;
+    frame[size++]     = TRACE_FRAME_END;
+
+    return console_trace_send(frame, size);
+}
+
+void console_trace_task(void) {
+    uint8_t record[TRACE_RECORD_SIZE];
+
+    while (trace_tail != trace_head) {
+        uint8_t length = trace_buffer[trace_tail++ & TRACE_MASK];
+        for (uint8_t i = 0; i < length; i++) {
+            record[i] = trace_buffer[trace_tail++ & TRACE_MASK];
+        }
+        if (!trace_send_frame(record, length)) {
+            trace_dropped++;
+        }
+    }
+
+    if (trace_dropped) {
+        // A record with a null format reports how many were lost
+        uintptr_t id      = 0;
+        uint16_t  time    = timer_read();
+        uint32_t  dropped = trace_dropped;
+        uint8_t  *cursor  = record;
+        memcpy(cursor, &id, sizeof(id));
+        cursor += sizeof(id);
+        memcpy(cursor, &time, sizeof(time));
+        cursor += sizeof(time);
+        memcpy(cursor, &dropped, sizeof(dropped));
+        if (trace_send_frame(record, TRACE_HEADER_SIZE + sizeof(dropped))) {
+            trace_dropped = 0;
+        }
+    }
+}
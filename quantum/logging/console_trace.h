@@ -0,0 +1,52 @@
+// Copyright 2023 QMK
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "progmem.h"
+
+/*
+ * Deferred console tracing.
+ *
+ * tprintf() stores the address of its format string, a millisecond timestamp
+ * and its raw arguments in a RAM ring buffer instead of formatting them, which
+ * keeps it cheap enough for the scan loop. console_trace_task() drains the
+ * buffer to the console from the main loop, and `qmk console-trace` formats
+ * the records on the host using the strings in the firmware's .elf file.
+ *
+ * Arguments are stored as 32 bit integers, so formats are limited to integer
+ * and character conversions; strings and pointers cannot be traced. Tracing is
+ * not interrupt safe.
+ */
+
+#ifndef CONSOLE_TRACE_BUFFER_SIZE
+#    define CONSOLE_TRACE_BUFFER_SIZE 256
+#endif
+
+#ifndef CONSOLE_TRACE_MAX_ARGS
+#    define CONSOLE_TRACE_MAX_ARGS 6
+#endif
+
+#ifdef CONSOLE_TRACE_ENABLE
+#    define tprintf(fmt, ...) console_trace_record(PSTR(fmt), (const uint32_t[]){__VA_ARGS__}, sizeof((const uint32_t[]){__VA_ARGS__}) / sizeof(uint32_t))
+#else
+#    define tprintf(fmt, ...)
+#endif
+
+/** \brief Appends a record to the trace buffer, or counts it as dropped if the buffer is full. */
+void console_trace_record(const char *fmt, const uint32_t *args, uint8_t count);
+
+/** \brief Sends every buffered record to the console. */
+void console_trace_task(void);
+
+/** \brief Writes one encoded record to the console.
+ *
+ * Protocols override this to queue the whole frame at once, and return false
+ * without sending anything if it does not fit. The default sends it through
+ * sendchar().
+ *
+ * \return true if the frame was queued, false if it was dropped
+ */
+bool console_trace_send(const uint8_t *data, uint8_t length);
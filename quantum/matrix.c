@@ -51,6 +51,13 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #    define MATRIX_INPUT_PRESSED_STATE 0
 #endif
 
+#ifdef MATRIX_COLS_ONLY_SCAN_TIMEOUT
+#    if defined(DIRECT_PINS) || !defined(MATRIX_ROW_PINS) || !defined(MATRIX_COL_PINS) || (DIODE_DIRECTION != COL2ROW)
+#        error MATRIX_COLS_ONLY_SCAN_TIMEOUT requires a COL2ROW matrix with MATRIX_ROW_PINS and MATRIX_COL_PINS
+#    endif
+#    include "keyboard.h"
+#endif
+
 #ifdef DIRECT_PINS
 static SPLIT_MUTABLE pin_t direct_pins[ROWS_PER_HAND][MATRIX_COLS] = DIRECT_PINS;
 #elif (DIODE_DIRECTION == ROW2COL) || (DIODE_DIRECTION == COL2ROW)
@@ -163,6 +170,89 @@ static void unselect_rows(void) {
     }
 }
 
+#            if defined(readPort) && !defined(MATRIX_READ_PINS_INDIVIDUALLY)
+#                define MATRIX_READ_COL_PORTS
+
+// A run of columns wired to consecutive bits of the same GPIO port, so that
+// the whole run can be moved into the matrix row with one shift and mask.
+typedef struct {
+    uint8_t      port;   // index into col_ports
+    uint8_t      bit;    // port bit of the first column
+    uint8_t      col;    // first column of the run
+    uint8_t      length; // number of columns in the run
+    matrix_row_t mask;
+} col_run_t;
+
+static pin_t     col_ports[MATRIX_COLS]; // one column pin of every port that holds columns
+static uint8_t   col_port_count = 0;
+static col_run_t col_runs[MATRIX_COLS];
+static uint8_t   col_run_count = 0;
+
+static void init_col_ports(void) {
+    col_port_count = 0;
+    col_run_count  = 0;
+
+    for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+        pin_t pin = col_pins[col];
+        if (pin == NO_PIN) {
+            continue;
+        }
+
+        uint8_t port = 0;
+        while (port < col_port_count && getPinPort(col_ports[port]) != getPinPort(pin)) {
+            port++;
+        }
+        if (port == col_port_count) {
+            col_ports[col_port_count++] = pin;
+        }
+
+        col_run_t *run = col_run_count ? &col_runs[col_run_count - 1] : NULL;
+        if (run && run->port == port && run->col + run->length == col && run->bit + run->length == getPinBit(pin)) {
+            run->length++;
+        } else {
+            run = &col_runs[col_run_count++];
+
+            run->port   = port;
+            run->bit    = getPinBit(pin);
+            run->col    = col;
+            run->length = 1;
+            run->mask   = 0;
+        }
+        run->mask = (run->mask << 1) | MATRIX_ROW_SHIFTER;
+    }
+}
+
+static matrix_row_t read_cols(void) {
+    port_data_t port_values[MATRIX_COLS];
+    for (uint8_t port = 0; port < col_port_count; port++) {
+        port_data_t value = readPort(col_ports[port]);
+        // Set bits are pressed keys from here on
+        port_values[port] = MATRIX_INPUT_PRESSED_STATE ? value : (port_data_t)~value;
+    }
+
+    matrix_row_t row_value = 0;
+    for (uint8_t i = 0; i < col_run_count; i++) {
+        const col_run_t *run = &col_runs[i];
+        row_value |= ((matrix_row_t)(port_values[run->port] >> run->bit) & run->mask) << run->col;
+    }
+    return row_value;
+}
+#            else
+static matrix_row_t read_cols(void) {
+    matrix_row_t row_value = 0;
+
+    // For each col...
+    matrix_row_t row_shifter = MATRIX_ROW_SHIFTER;
+    for (uint8_t col_index = 0; col_index < MATRIX_COLS; col_index++, row_shifter <<= 1) {
+        uint8_t pin_state = readMatrixPin(col_pins[col_index]);
+
+        // Populate the matrix row with the state of the col pin
+        row_value |= pin_state ? 0 : row_shifter;
+    }
+    return row_value;
+}
+#            endif
+
 __attribute__((weak)) void matrix_init_pins(void) {
     unselect_rows();
     for (uint8_t x = 0; x < MATRIX_COLS; x++) {
@@ -173,22 +263,13 @@ __attribute__((weak)) void matrix_init_pins(void) {
 }
 
 __attribute__((weak)) void matrix_read_cols_on_row(matrix_row_t current_matrix[], uint8_t current_row) {
-    // Start with a clear matrix row
-    matrix_row_t current_row_value = 0;
-
     if (!select_row(current_row)) { // Select row
         return;                     // skip NO_PIN row
     }
     matrix_output_select_delay();
 
-    // For each col...
-    matrix_row_t row_shifter = MATRIX_ROW_SHIFTER;
-    for (uint8_t col_index = 0; col_index < MATRIX_COLS; col_index++, row_shifter <<= 1) {
-        uint8_t pin_state = readMatrixPin(col_pins[col_index]);
-
-        // Populate the matrix row with the state of the col pin
-        current_row_value |= pin_state ? 0 : row_shifter;
-    }
+    // Read the state of every col
+    matrix_row_t current_row_value = read_cols();
 
     // Unselect row
     unselect_row(current_row);
@@ -198,6 +279,53 @@ __attribute__((weak)) void matrix_read_cols_on_row(matrix_row_t current_matrix[]
     current_matrix[current_row] = current_row_value;
 }
 
+#            ifdef MATRIX_ADAPTIVE_UNSELECT_DELAY
+bool matrix_unselect_pending(void) {
+    return read_cols() != 0;
+}
+#            endif
+
+#            ifdef MATRIX_COLS_ONLY_SCAN_TIMEOUT
+static bool all_rows_selected = false;
+
+// Select every row at once, so that pressing any key pulls its col LOW
+static void select_all_rows(void) {
+    for (uint8_t row = 0; row < ROWS_PER_HAND; row++) {
+        select_row(row);
+    }
+    matrix_output_select_delay();
+    all_rows_selected = true;
+}
+
+// Returns true while all rows are selected and no key is pressed, so the row scan can be skipped
+static bool matrix_cols_only_scan(void) {
+    if (!all_rows_selected) {
+        return false;
+    }
+    if (!read_cols()) {
+        return true;
+    }
+
+    // A key went down, go back to scanning row by row right away so the press is not lost
+    unselect_rows();
+    matrix_output_unselect_delay(0, true);
+    all_rows_selected = false;
+    return false;
+}
+
+static void matrix_cols_only_scan_update(void) {
+    if (all_rows_selected || last_matrix_activity_elapsed() < MATRIX_COLS_ONLY_SCAN_TIMEOUT) {
+        return;
+    }
+    for (uint8_t row = 0; row < ROWS_PER_HAND; row++) {
+        if (raw_matrix[row]) {
+            return;
+        }
+    }
+    select_all_rows();
+}
+#            endif
+
 #        elif (DIODE_DIRECTION == ROW2COL)
 
 static bool select_col(uint8_t col) {
@@ -262,6 +390,17 @@ __attribute__((weak)) void matrix_read_rows_on_col(matrix_row_t current_matrix[]
     matrix_output_unselect_delay(current_col, key_pressed); // wait for all Row signals to go HIGH
 }
 
+#            ifdef MATRIX_ADAPTIVE_UNSELECT_DELAY
+bool matrix_unselect_pending(void) {
+    for (uint8_t row_index = 0; row_index < ROWS_PER_HAND; row_index++) {
+        if (readMatrixPin(row_pins[row_index]) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+#            endif
+
 #        else
 #            error DIODE_DIRECTION must be one of COL2ROW or ROW2COL!
 #        endif
@@ -302,6 +441,9 @@ void matrix_init(void) {
 
     // initialize key pins
     matrix_init_pins();
+#ifdef MATRIX_READ_COL_PORTS
+    init_col_ports();
+#endif
 
     // initialize matrix state: all keys off
     memset(matrix, 0, sizeof(matrix));
@@ -323,7 +465,14 @@ __attribute__((weak)) bool transport_master_if_connected(matrix_row_t master_mat
 uint8_t matrix_scan(void) {
     matrix_row_t curr_matrix[MATRIX_ROWS] = {0};
 
-#if defined(DIRECT_PINS) || (DIODE_DIRECTION == COL2ROW)
+#if defined(MATRIX_COLS_ONLY_SCAN_TIMEOUT)
+    // While all rows are selected, a single read of the cols tells whether any key is down
+    if (!matrix_cols_only_scan()) {
+        for (uint8_t current_row = 0; current_row < ROWS_PER_HAND; current_row++) {
+            matrix_read_cols_on_row(curr_matrix, current_row);
+        }
+    }
+#elif defined(DIRECT_PINS) || (DIODE_DIRECTION == COL2ROW)
     // Set row, read cols
     for (uint8_t current_row = 0; current_row < ROWS_PER_HAND; current_row++) {
         matrix_read_cols_on_row(curr_matrix, current_row);
@@ -345,5 +494,9 @@ uint8_t matrix_scan(void) {
     changed = debounce(raw_matrix, matrix, ROWS_PER_HAND, changed);
     matrix_scan_kb();
 #endif
+
+#ifdef MATRIX_COLS_ONLY_SCAN_TIMEOUT
+    matrix_cols_only_scan_update();
+#endif
     return (uint8_t)changed;
 }
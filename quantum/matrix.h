@@ -62,6 +62,8 @@ void matrix_print(void);
 /* delay between changing matrix pin state and reading values */
 void matrix_output_select_delay(void);
 void matrix_output_unselect_delay(uint8_t line, bool key_pressed);
+/* whether any input line is still pulled LOW after unselecting, used by MATRIX_ADAPTIVE_UNSELECT_DELAY */
+bool matrix_unselect_pending(void);
 /* only for backwards compatibility. delay between changing matrix pin state and reading values */
 void matrix_io_delay(void);
 
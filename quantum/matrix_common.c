@@ -129,8 +129,22 @@ __attribute__((weak)) void matrix_io_delay(void) {
 __attribute__((weak)) void matrix_output_select_delay(void) {
     waitInputPinDelay();
 }
+#ifdef MATRIX_ADAPTIVE_UNSELECT_DELAY
+/* Custom matrices without their own check always wait the full delay. */
+__attribute__((weak)) bool matrix_unselect_pending(void) {
+    return true;
+}
+#endif
 __attribute__((weak)) void matrix_output_unselect_delay(uint8_t line, bool key_pressed) {
+#ifdef MATRIX_ADAPTIVE_UNSELECT_DELAY
+    // Opt-in: only wait until the lines pulled LOW by pressed keys read HIGH again.
+    // The scan itself is unchanged, the next row is not read until this returns.
+    for (uint16_t i = 0; key_pressed && i < MATRIX_IO_DELAY && matrix_unselect_pending(); i++) {
+        wait_us(1);
+    }
+#else
     matrix_io_delay();
+#endif
 }
 
 // CUSTOM MATRIX 'LITE'
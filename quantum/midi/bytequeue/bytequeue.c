@@ -1,4 +1,4 @@
-// this is a single reader [maybe multiple writer?] byte queue
+// this is a single reader, single writer lock-free byte queue
 // Copyright 2008 Alex Norman
 // writen by Alex Norman
 //
@@ -18,47 +18,87 @@
 // along with avr-bytequeue.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "bytequeue.h"
-#include "interrupt_setting.h"
+
+/* Publishing an index must not be reordered with the data accesses it guards.
+ * AVR and single core Cortex-M only need the compiler to respect that order
+ * (ISRs observe memory in program order); the DMB also keeps multi-core parts
+ * such as the RP2040 correct.
+ */
+#if defined(__arm__)
+#    define bytequeue_barrier() __asm__ volatile("dmb" ::: "memory")
+#elif defined(__AVR__)
+#    define bytequeue_barrier() __asm__ volatile("" ::: "memory")
+#else
+#    define bytequeue_barrier() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#endif
 
 void bytequeue_init(byteQueue_t* queue, uint8_t* dataArray, byteQueueIndex_t arrayLen) {
-    queue->length = arrayLen;
-    queue->data   = dataArray;
+    queue->mask = arrayLen - 1;
+    queue->data = dataArray;
     queue->start = queue->end = 0;
 }
 
 bool bytequeue_enqueue(byteQueue_t* queue, uint8_t item) {
-    interrupt_setting_t setting = store_and_clear_interrupt();
+    byteQueueIndex_t end  = queue->end;
+    byteQueueIndex_t next = (end + 1) & queue->mask;
     // full
-    if (((queue->end + 1) % queue->length) == queue->start) {
-        restore_interrupt_setting(setting);
+    if (next == queue->start) {
         return false;
-    } else {
-        queue->data[queue->end] = item;
-        queue->end              = (queue->end + 1) % queue->length;
-        restore_interrupt_setting(setting);
-        return true;
     }
+    queue->data[end] = item;
+    bytequeue_barrier();
+    queue->end = next;
+    return true;
+}
+
+bool bytequeue_enqueue_bulk(byteQueue_t* queue, const uint8_t* items, byteQueueIndex_t count) {
+    if (count > bytequeue_free(queue)) {
+        return false;
+    }
+    byteQueueIndex_t end = queue->end;
+    for (byteQueueIndex_t i = 0; i < count; i++) {
+        queue->data[end] = items[i];
+        end              = (end + 1) & queue->mask;
+    }
+    bytequeue_barrier();
+    queue->end = end;
+    return true;
 }
 
 byteQueueIndex_t bytequeue_length(byteQueue_t* queue) {
-    byteQueueIndex_t    len;
-    interrupt_setting_t setting = store_and_clear_interrupt();
-    if (queue->end >= queue->start)
-        len = queue->end - queue->start;
-    else
-        len = (queue->length - queue->start) + queue->end;
-    restore_interrupt_setting(setting);
-    return len;
+    return (queue->end - queue->start) & queue->mask;
+}
+
+byteQueueIndex_t bytequeue_free(byteQueue_t* queue) {
+    return queue->mask - bytequeue_length(queue);
 }
 
-// we don't need to avoid interrupts if there is only one reader
 uint8_t bytequeue_get(byteQueue_t* queue, byteQueueIndex_t index) {
-    return queue->data[(queue->start + index) % queue->length];
+    bytequeue_barrier();
+    return queue->data[(queue->start + index) & queue->mask];
+}
+
+byteQueueIndex_t bytequeue_peek(byteQueue_t* queue, uint8_t* dest, byteQueueIndex_t maxCount) {
+    byteQueueIndex_t start = queue->start;
+    byteQueueIndex_t count = (queue->end - start) & queue->mask;
+    if (count > maxCount) {
+        count = maxCount;
+    }
+    bytequeue_barrier();
+    for (byteQueueIndex_t i = 0; i < count; i++) {
+        dest[i] = queue->data[start];
+        start   = (start + 1) & queue->mask;
+    }
+    return count;
 }
 
-// we just update the start index to remove elements
 void bytequeue_remove(byteQueue_t* queue, byteQueueIndex_t numToRemove) {
-    interrupt_setting_t setting = store_and_clear_interrupt();
-    queue->start                = (queue->start + numToRemove) % queue->length;
-    restore_interrupt_setting(setting);
+    bytequeue_barrier();
+    queue->start = (queue->start + numToRemove) & queue->mask;
+}
+
+byteQueueIndex_t bytequeue_dequeue(byteQueue_t* queue, uint8_t* dest, byteQueueIndex_t maxCount) {
+    byteQueueIndex_t count = bytequeue_peek(queue, dest, maxCount);
+    bytequeue_remove(queue, count);
+    return count;
 }
@@ -1,4 +1,4 @@
-// this is a single reader [maybe multiple writer?] byte queue
+// this is a single reader, single writer lock-free byte queue
 // Copyright 2008 Alex Norman
 // writen by Alex Norman
 //
@@ -28,28 +28,45 @@ extern "C" {
 
 typedef uint8_t byteQueueIndex_t;
 
+/* The queue is safe to use without disabling interrupts as long as there is
+ * exactly one producer (calling bytequeue_enqueue*) and one consumer (calling
+ * bytequeue_get/peek/remove/dequeue), for example an ISR and the main loop.
+ *
+ * The backing array length must be a power of two.  One slot is always left
+ * empty to tell a full queue from an empty one, so an array of N bytes holds
+ * at most N - 1 bytes.
+ */
 typedef struct {
-    byteQueueIndex_t start;
-    byteQueueIndex_t end;
-    byteQueueIndex_t length;
-    uint8_t*         data;
+    volatile byteQueueIndex_t start; // only written by the consumer
+    volatile byteQueueIndex_t end;   // only written by the producer
+    byteQueueIndex_t          mask;
+    uint8_t*                  data;
 } byteQueue_t;
 
-// you must have a queue, an array of data which the queue will use, and the length of that array
+#define BYTEQUEUE_INITIALIZER(dataArray) \
+    { .start = 0, .end = 0, .mask = sizeof(dataArray) - 1, .data = (dataArray) }
+
 void bytequeue_init(byteQueue_t* queue, uint8_t* dataArray, byteQueueIndex_t arrayLen);
 
-// add an item to the queue, returns false if the queue is full
 bool bytequeue_enqueue(byteQueue_t* queue, uint8_t item);
 
-// get the length of the queue
+// enqueue all of the given bytes, or none of them if there is not enough space
+bool bytequeue_enqueue_bulk(byteQueue_t* queue, const uint8_t* items, byteQueueIndex_t count);
+
 byteQueueIndex_t bytequeue_length(byteQueue_t* queue);
 
-// this grabs data at the index given [starting at queue->start]
+byteQueueIndex_t bytequeue_free(byteQueue_t* queue);
+
 uint8_t bytequeue_get(byteQueue_t* queue, byteQueueIndex_t index);
 
-// update the index in the queue to reflect data that has been dealt with
+// copy up to maxCount bytes from the front of the queue without removing them
+byteQueueIndex_t bytequeue_peek(byteQueue_t* queue, uint8_t* dest, byteQueueIndex_t maxCount);
+
 void bytequeue_remove(byteQueue_t* queue, byteQueueIndex_t numToRemove);
 
+// copy and remove up to maxCount bytes from the front of the queue
+byteQueueIndex_t bytequeue_dequeue(byteQueue_t* queue, uint8_t* dest, byteQueueIndex_t maxCount);
+
 #ifdef __cplusplus
 }
 #endif
@@ -31,6 +31,7 @@ void midi_device_init(MidiDevice* device) {
     device->input_state = IDLE;
     device->input_count = 0;
     bytequeue_init(&device->input_queue, device->input_queue_data, MIDI_INPUT_QUEUE_LENGTH);
+    bytequeue_init(&device->output_queue, device->output_queue_data, MIDI_OUTPUT_QUEUE_LENGTH);
 
     // three byte funcs
     device->input_cc_callback           = NULL;
@@ -59,9 +60,26 @@ void midi_device_init(MidiDevice* device) {
 }
 
 void midi_device_input(MidiDevice* device, uint8_t cnt, uint8_t* input) {
-    uint8_t i;
-    for (i = 0; i < cnt; i++)
-        bytequeue_enqueue(&device->input_queue, input[i]);
+    // whole packets only, so a full queue never leaves a partial message behind
+    bytequeue_enqueue_bulk(&device->input_queue, input, cnt);
+}
+
+// output packets are queued as [cnt, byte0, byte1, byte2]
+#define MIDI_OUTPUT_PACKET_SIZE 4
+
+void midi_device_send(MidiDevice* device, uint8_t cnt, uint8_t byte0, uint8_t byte1, uint8_t byte2) {
+    uint8_t packet[MIDI_OUTPUT_PACKET_SIZE] = {cnt, byte0, byte1, byte2};
+    if (!bytequeue_enqueue_bulk(&device->output_queue, packet, MIDI_OUTPUT_PACKET_SIZE)) {
+        midi_device_flush(device);
+        device->send_func(device, cnt, byte0, byte1, byte2);
+    }
+}
+
+void midi_device_flush(MidiDevice* device) {
+    uint8_t packet[MIDI_OUTPUT_PACKET_SIZE];
+    while (bytequeue_dequeue(&device->output_queue, packet, MIDI_OUTPUT_PACKET_SIZE) == MIDI_OUTPUT_PACKET_SIZE) {
+        device->send_func(device, packet[0], packet[1], packet[2], packet[3]);
+    }
 }
 
 void midi_device_set_send_func(MidiDevice* device, midi_var_byte_func_t send_func) {
@@ -76,15 +94,20 @@ void midi_device_process(MidiDevice* device) {
     // call the pre_input_process_callback if there is one
     if (device->pre_input_process_callback) device->pre_input_process_callback(device);
 
-    // pull stuff off the queue and process
+    // pull stuff off the queue and process, only what was there when we
+    // started so that input arriving meanwhile waits for the next call
     byteQueueIndex_t len = bytequeue_length(&device->input_queue);
-    uint16_t         i;
-    // TODO limit number of bytes processed?
-    for (i = 0; i < len; i++) {
-        uint8_t val = bytequeue_get(&device->input_queue, 0);
-        midi_process_byte(device, val);
-        bytequeue_remove(&device->input_queue, 1);
+    uint8_t          buffer[16];
+    while (len > 0) {
+        byteQueueIndex_t count = bytequeue_dequeue(&device->input_queue, buffer, len < sizeof(buffer) ? len : sizeof(buffer));
+        for (byteQueueIndex_t i = 0; i < count; i++) {
+            midi_process_byte(device, buffer[i]);
+        }
+        len -= count;
     }
+
+    // send anything queued by the callbacks or since the last call
+    midi_device_flush(device);
 }
 
 void midi_process_byte(MidiDevice* device, uint8_t input) {
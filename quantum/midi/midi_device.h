@@ -48,7 +48,16 @@ extern "C" {
 
 #include "midi_function_types.h"
 #include "bytequeue/bytequeue.h"
-#define MIDI_INPUT_QUEUE_LENGTH 192
+
+// queue lengths must be powers of two
+#ifndef MIDI_INPUT_QUEUE_LENGTH
+#    define MIDI_INPUT_QUEUE_LENGTH 128
+#endif
+#ifndef MIDI_OUTPUT_QUEUE_LENGTH
+#    define MIDI_OUTPUT_QUEUE_LENGTH 64
+#endif
+_Static_assert(MIDI_INPUT_QUEUE_LENGTH <= 256 && (MIDI_INPUT_QUEUE_LENGTH & (MIDI_INPUT_QUEUE_LENGTH - 1)) == 0, "MIDI_INPUT_QUEUE_LENGTH must be a power of two no larger than 256");
+_Static_assert(MIDI_OUTPUT_QUEUE_LENGTH <= 256 && (MIDI_OUTPUT_QUEUE_LENGTH & (MIDI_OUTPUT_QUEUE_LENGTH - 1)) == 0, "MIDI_OUTPUT_QUEUE_LENGTH must be a power of two no larger than 256");
 
 typedef enum { IDLE, ONE_BYTE_MESSAGE = 1, TWO_BYTE_MESSAGE = 2, THREE_BYTE_MESSAGE = 3, SYSEX_MESSAGE } input_state_t;
 
@@ -104,6 +113,10 @@ struct _midi_device {
     // for queueing data between the input and the processing functions
     uint8_t     input_queue_data[MIDI_INPUT_QUEUE_LENGTH];
     byteQueue_t input_queue;
+
+    // for queueing packets between the send functions and the send_func
+    uint8_t     output_queue_data[MIDI_OUTPUT_QUEUE_LENGTH];
+    byteQueue_t output_queue;
 };
 
 /**
@@ -118,6 +131,26 @@ struct _midi_device {
  */
 void midi_device_input(MidiDevice* device, uint8_t cnt, uint8_t* input);
 
+/**
+ * @brief Queue a packet for output.  The packet is passed to the device's
+ * send function the next time midi_device_process is called, or straight
+ * away if the output queue is full.
+ *
+ * @param device the midi device to send the packet through
+ * @param cnt the number of valid bytes in the packet, 1 to 3
+ * @param byte0 the first byte of the packet
+ * @param byte1 the second byte of the packet
+ * @param byte2 the third byte of the packet
+ */
+void midi_device_send(MidiDevice* device, uint8_t cnt, uint8_t byte0, uint8_t byte1, uint8_t byte2);
+
+/**
+ * @brief Pass every queued output packet to the device's send function.
+ *
+ * @param device the midi device to flush
+ */
+void midi_device_flush(MidiDevice* device);
+
 /**
  * @brief Set the callback function that will be used for sending output
  * data bytes.  This is only used if you're creating a custom device.
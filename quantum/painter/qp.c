@@ -6,6 +6,7 @@
 
 #include "qp_internal.h"
 #include "qp_comms.h"
+#include "basic_profiling.h"
 #include "qp_draw.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -124,7 +125,7 @@ bool qp_flush(painter_device_t device) {
         return false;
     }
 
-    bool ret = driver->driver_vtable->flush(device);
+    bool ret = PROFILE_ZONE_EXPR("qp_flush", driver->driver_vtable->flush(device));
     qp_comms_stop(device);
     qp_dprintf("qp_flush: %s\n", ret ? "ok" : "fail");
     return ret;
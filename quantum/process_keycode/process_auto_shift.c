@@ -321,6 +321,23 @@ void autoshift_matrix_scan(void) {
     }
 }
 
+/** \brief Milliseconds until autoshift_matrix_scan() shifts the held key
+ *
+ *  Returns TIMER_NO_DEADLINE if no auto-shiftable key is in progress.
+ */
+uint32_t autoshift_next_deadline(void) {
+    if (!autoshift_flags.in_progress) {
+        return TIMER_NO_DEADLINE;
+    }
+    uint16_t elapsed = timer_elapsed(autoshift_time);
+#ifdef AUTO_SHIFT_TIMEOUT_PER_KEY
+    uint16_t timeout = get_autoshift_timeout(autoshift_lastkey, &autoshift_lastrecord);
+#else
+    uint16_t timeout = autoshift_timeout;
+#endif
+    return elapsed >= timeout ? 0 : timeout - elapsed;
+}
+
 void autoshift_toggle(void) {
     autoshift_flags.enabled = !autoshift_flags.enabled;
     autoshift_flush_shift();
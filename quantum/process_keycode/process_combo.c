@@ -625,6 +625,16 @@ void combo_task(void) {
 #endif
 }
 
+uint32_t combo_next_deadline(void) {
+#ifndef COMBO_NO_TIMER
+    if (b_combo_enable && timer) {
+        uint16_t elapsed = timer_elapsed(timer);
+        return elapsed > longest_term ? 0 : longest_term + 1 - elapsed;
+    }
+#endif
+    return TIMER_NO_DEADLINE;
+}
+
 void combo_enable(void) {
     b_combo_enable = true;
 }
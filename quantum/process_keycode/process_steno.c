@@ -47,15 +47,74 @@ static inline void steno_clear_chord(void) {
     memset(chord, 0, sizeof(chord));
 }
 
+#ifdef VIRTSER_ENABLE
+#    ifndef STENO_STROKE_BUFFER_SIZE
+#        define STENO_STROKE_BUFFER_SIZE 8
+#    endif
+
+// Completed strokes waiting for room in the virtual serial transmit queue.
+// Each stroke is handed over as a whole packet, so a congested endpoint can
+// delay a stroke but never split it.
+typedef struct {
+    uint8_t length;
+    uint8_t data[MAX_STROKE_SIZE + 1];
+} steno_stroke_t;
+
+static steno_stroke_t       strokes[STENO_STROKE_BUFFER_SIZE];
+static uint8_t              stroke_head  = 0;
+static uint8_t              stroke_count = 0;
+static steno_stroke_stats_t stroke_stats = {0};
+
+static void steno_flush_strokes(void) {
+    while (stroke_count) {
+        steno_stroke_t *stroke = &strokes[stroke_head];
+        if (!virtser_send_packet(stroke->data, stroke->length)) {
+            return;
+        }
+        stroke_head = (stroke_head + 1) % STENO_STROKE_BUFFER_SIZE;
+        stroke_count--;
+    }
+}
+
+static void steno_queue_stroke(const uint8_t *data, uint8_t length) {
+    // Make room first, the oldest stroke may fit by now.
+    steno_flush_strokes();
+    if (stroke_count == STENO_STROKE_BUFFER_SIZE) {
+        stroke_stats.dropped++;
+        return;
+    }
+
+    steno_stroke_t *stroke = &strokes[(stroke_head + stroke_count) % STENO_STROKE_BUFFER_SIZE];
+    stroke->length         = length;
+    memcpy(stroke->data, data, length);
+    stroke_count++;
+    stroke_stats.sent++;
+
+    steno_flush_strokes();
+    if (stroke_count) {
+        // The queue is first in first out, so the new stroke is still waiting.
+        stroke_stats.delayed++;
+    }
+}
+
+steno_stroke_stats_t steno_get_stroke_stats(void) {
+    return stroke_stats;
+}
+#endif // VIRTSER_ENABLE
+
+void steno_task(void) {
+#ifdef VIRTSER_ENABLE
+    steno_flush_strokes();
+#endif
+}
+
 #ifdef STENO_ENABLE_GEMINI
 
 #    ifdef VIRTSER_ENABLE
 void send_steno_chord_gemini(void) {
     // Set MSB to 1 to indicate the start of packet
     chord[0] |= 0x80;
-    for (uint8_t i = 0; i < GEMINI_STROKE_SIZE; ++i) {
-        virtser_send(chord[i]);
-    }
+    steno_queue_stroke(chord, GEMINI_STROKE_SIZE);
 }
 #    else
 #        pragma message "VIRTSER_ENABLE = yes is required for Gemini PR to work properly out of the box!"
@@ -93,18 +152,21 @@ static const uint8_t boltmap[64] PROGMEM = {TXB_NUL, TXB_NUM, TXB_NUM, TXB_NUM,
 
 #    ifdef VIRTSER_ENABLE
 static void send_steno_chord_bolt(void) {
+    uint8_t packet[BOLT_STROKE_SIZE + 1];
+    uint8_t length = 0;
     for (uint8_t i = 0; i < BOLT_STROKE_SIZE; ++i) {
         // TX Bolt uses variable length packets where each byte corresponds to a bit array of certain keys.
         // If a user chorded the keys of the first group with keys of the last group, for example, there
         // would be bytes of 0x00 in `chord` for the middle groups which we mustn't send.
         if (chord[i]) {
-            virtser_send(chord[i]);
+            packet[length++] = chord[i];
         }
     }
     // Sending a null packet is not always necessary, but it is simpler and more reliable
     // to unconditionally send it every time instead of keeping track of more states and
     // creating more branches in the execution of the program.
-    virtser_send(0);
+    packet[length++] = 0;
+    steno_queue_stroke(packet, length);
 }
 #    else
 #        pragma message "VIRTSER_ENABLE = yes is required for TX Bolt to work properly out of the box!"
@@ -35,8 +35,18 @@ typedef enum {
     STENO_MODE_BOLT,
 } steno_mode_t;
 
+typedef struct {
+    uint16_t sent;    // strokes handed to the stroke buffer
+    uint16_t delayed; // strokes that had to wait for room in the virtual serial queue
+    uint16_t dropped; // strokes lost because the stroke buffer was full
+} steno_stroke_stats_t;
+
 bool process_steno(uint16_t keycode, keyrecord_t *record);
+void steno_task(void);
 #ifdef STENO_ENABLE_ALL
 void steno_init(void);
 void steno_set_mode(steno_mode_t mode);
 #endif // STENO_ENABLE_ALL
+#ifdef VIRTSER_ENABLE
+steno_stroke_stats_t steno_get_stroke_stats(void);
+#endif // VIRTSER_ENABLE
@@ -15,6 +15,7 @@
  */
 
 #include "quantum.h"
+#include "basic_profiling.h"
 
 #if defined(BACKLIGHT_ENABLE) || defined(LED_MATRIX_ENABLE)
 #    include "process_backlight.h"
@@ -245,7 +246,7 @@ bool pre_process_record_quantum(keyrecord_t *record) {
     uint16_t keycode = get_record_keycode(record, true);
     return pre_process_record_kb(keycode, record) &&
 #ifdef COMBO_ENABLE
-           process_combo(keycode, record) &&
+           PROFILE_ZONE_EXPR("process_combo", process_combo(keycode, record)) &&
 #endif
            true;
 }
@@ -299,93 +300,93 @@ bool process_record_quantum(keyrecord_t *record) {
     if (!(
 #if defined(KEY_LOCK_ENABLE)
             // Must run first to be able to mask key_up events.
-            process_key_lock(&keycode, record) &&
+            PROFILE_ZONE_EXPR("process_key_lock", process_key_lock(&keycode, record)) &&
 #endif
 #if defined(DYNAMIC_MACRO_ENABLE) && !defined(DYNAMIC_MACRO_USER_CALL)
             // Must run asap to ensure all keypresses are recorded.
-            process_dynamic_macro(keycode, record) &&
+            PROFILE_ZONE_EXPR("process_dynamic_macro", process_dynamic_macro(keycode, record)) &&
 #endif
 #ifdef REPEAT_KEY_ENABLE
-            process_last_key(keycode, record) && process_repeat_key(keycode, record) &&
+            PROFILE_ZONE_EXPR("process_last_key", process_last_key(keycode, record)) && PROFILE_ZONE_EXPR("process_repeat_key", process_repeat_key(keycode, record)) &&
 #endif
 #if defined(AUDIO_ENABLE) && defined(AUDIO_CLICKY)
-            process_clicky(keycode, record) &&
+            PROFILE_ZONE_EXPR("process_clicky", process_clicky(keycode, record)) &&
 #endif
 #ifdef HAPTIC_ENABLE
-            process_haptic(keycode, record) &&
+            PROFILE_ZONE_EXPR("process_haptic", process_haptic(keycode, record)) &&
 #endif
 #if defined(VIA_ENABLE)
-            process_record_via(keycode, record) &&
+            PROFILE_ZONE_EXPR("process_record_via", process_record_via(keycode, record)) &&
 #endif
 #if defined(POINTING_DEVICE_ENABLE) && defined(POINTING_DEVICE_AUTO_MOUSE_ENABLE)
-            process_auto_mouse(keycode, record) &&
+            PROFILE_ZONE_EXPR("process_auto_mouse", process_auto_mouse(keycode, record)) &&
 #endif
-            process_record_kb(keycode, record) &&
+            PROFILE_ZONE_EXPR("process_record_kb", process_record_kb(keycode, record)) &&
 #if defined(SECURE_ENABLE)
-            process_secure(keycode, record) &&
+            PROFILE_ZONE_EXPR("process_secure", process_secure(keycode, record)) &&
 #endif
 #if defined(SEQUENCER_ENABLE)
-            process_sequencer(keycode, record) &&
+            PROFILE_ZONE_EXPR("process_sequencer", process_sequencer(keycode, record)) &&
 #endif
 #if defined(MIDI_ENABLE) && defined(MIDI_ADVANCED)
-            process_midi(keycode, record) &&
+            PROFILE_ZONE_EXPR("process_midi", process_midi(keycode, record)) &&
 #endif
 #ifdef AUDIO_ENABLE
-            process_audio(keycode, record) &&
+            PROFILE_ZONE_EXPR("process_audio", process_audio(keycode, record)) &&
 #endif
 #if defined(BACKLIGHT_ENABLE) || defined(LED_MATRIX_ENABLE)
-            process_backlight(keycode, record) &&
+            PROFILE_ZONE_EXPR("process_backlight", process_backlight(keycode, record)) &&
 #endif
 #ifdef STENO_ENABLE
-            process_steno(keycode, record) &&
+            PROFILE_ZONE_EXPR("process_steno", process_steno(keycode, record)) &&
 #endif
 #if (defined(AUDIO_ENABLE) || (defined(MIDI_ENABLE) && defined(MIDI_BASIC))) && !defined(NO_MUSIC_MODE)
-            process_music(keycode, record) &&
+            PROFILE_ZONE_EXPR("process_music", process_music(keycode, record)) &&
 #endif
 #ifdef CAPS_WORD_ENABLE
-            process_caps_word(keycode, record) &&
+            PROFILE_ZONE_EXPR("process_caps_word", process_caps_word(keycode, record)) &&
 #endif
 #ifdef KEY_OVERRIDE_ENABLE
-            process_key_override(keycode, record) &&
+            PROFILE_ZONE_EXPR("process_key_override", process_key_override(keycode, record)) &&
 #endif
 #ifdef TAP_DANCE_ENABLE
-            process_tap_dance(keycode, record) &&
+            PROFILE_ZONE_EXPR("process_tap_dance", process_tap_dance(keycode, record)) &&
 #endif
 #if defined(UNICODE_COMMON_ENABLE)
-            process_unicode_common(keycode, record) &&
+            PROFILE_ZONE_EXPR("process_unicode_common", process_unicode_common(keycode, record)) &&
 #endif
 #ifdef LEADER_ENABLE
-            process_leader(keycode, record) &&
+            PROFILE_ZONE_EXPR("process_leader", process_leader(keycode, record)) &&
 #endif
 #ifdef AUTO_SHIFT_ENABLE
-            process_auto_shift(keycode, record) &&
+            PROFILE_ZONE_EXPR("process_auto_shift", process_auto_shift(keycode, record)) &&
 #endif
 #ifdef DYNAMIC_TAPPING_TERM_ENABLE
-            process_dynamic_tapping_term(keycode, record) &&
+            PROFILE_ZONE_EXPR("process_dynamic_tapping_term", process_dynamic_tapping_term(keycode, record)) &&
 #endif
 #ifdef SPACE_CADET_ENABLE
-            process_space_cadet(keycode, record) &&
+            PROFILE_ZONE_EXPR("process_space_cadet", process_space_cadet(keycode, record)) &&
 #endif
 #ifdef MAGIC_ENABLE
-            process_magic(keycode, record) &&
+            PROFILE_ZONE_EXPR("process_magic", process_magic(keycode, record)) &&
 #endif
 #ifdef GRAVE_ESC_ENABLE
-            process_grave_esc(keycode, record) &&
+            PROFILE_ZONE_EXPR("process_grave_esc", process_grave_esc(keycode, record)) &&
 #endif
 #if defined(RGBLIGHT_ENABLE) || defined(RGB_MATRIX_ENABLE)
-            process_rgb(keycode, record) &&
+            PROFILE_ZONE_EXPR("process_rgb", process_rgb(keycode, record)) &&
 #endif
 #ifdef JOYSTICK_ENABLE
-            process_joystick(keycode, record) &&
+            PROFILE_ZONE_EXPR("process_joystick", process_joystick(keycode, record)) &&
 #endif
 #ifdef PROGRAMMABLE_BUTTON_ENABLE
-            process_programmable_button(keycode, record) &&
+            PROFILE_ZONE_EXPR("process_programmable_button", process_programmable_button(keycode, record)) &&
 #endif
 #ifdef AUTOCORRECT_ENABLE
-            process_autocorrect(keycode, record) &&
+            PROFILE_ZONE_EXPR("process_autocorrect", process_autocorrect(keycode, record)) &&
 #endif
 #ifdef TRI_LAYER_ENABLE
-            process_tri_layer(keycode, record) &&
+            PROFILE_ZONE_EXPR("process_tri_layer", process_tri_layer(keycode, record)) &&
 #endif
             true)) {
         return false;
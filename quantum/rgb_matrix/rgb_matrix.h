@@ -173,6 +173,13 @@ void process_rgb_matrix(uint8_t row, uint8_t col, bool pressed);
 
 void rgb_matrix_task(void);
 
+// Milliseconds until rgb_matrix_task() has work to do again
+uint32_t rgb_matrix_next_deadline(void);
+
+// Writes pending config changes to EEPROM, done by the engine sync unless
+// THREADED_TASKS_ENABLE moves the task off the main thread
+void rgb_matrix_eeconfig_task(void);
+
 void rgb_matrix_none_indicators_kb(void);
 void rgb_matrix_none_indicators_user(void);
 
@@ -95,6 +95,24 @@ void secure_task(void) {
 #endif
 }
 
+uint32_t secure_next_deadline(void) {
+#if SECURE_UNLOCK_TIMEOUT != 0
+    if (secure_status == SECURE_PENDING) {
+        uint32_t elapsed = timer_elapsed32(unlock_time);
+        return elapsed >= SECURE_UNLOCK_TIMEOUT ? 0 : SECURE_UNLOCK_TIMEOUT - elapsed;
+    }
+#endif
+
+#if SECURE_IDLE_TIMEOUT != 0
+    if (secure_status == SECURE_UNLOCKED) {
+        uint32_t elapsed = timer_elapsed32(idle_time);
+        return elapsed >= SECURE_IDLE_TIMEOUT ? 0 : SECURE_IDLE_TIMEOUT - elapsed;
+    }
+#endif
+
+    return TIMER_NO_DEADLINE;
+}
+
 __attribute__((weak)) bool secure_hook_user(secure_status_t secure_status) {
     return true;
 }
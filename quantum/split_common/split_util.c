@@ -52,8 +52,25 @@
 #    define SPLIT_CONNECTION_CHECK_TIMEOUT 500
 #endif // SPLIT_CONNECTION_CHECK_TIMEOUT
 
+// Print the serial link statistics to the debug console every this many milliseconds on the master.
+// Set to 0 to only print them when the link drops or the watchdog fires.
+#ifndef SPLIT_LINK_STATS_PRINT_INTERVAL
+#    define SPLIT_LINK_STATS_PRINT_INTERVAL 0
+#endif // SPLIT_LINK_STATS_PRINT_INTERVAL
+
 static uint8_t connection_errors = 0;
 
+#if defined(SPLIT_COMMON_TRANSACTIONS) && !defined(USE_I2C)
+#    include "serial.h"
+
+static void split_print_link_stats(void) {
+    const serial_link_stats_t *stats = serial_link_get_stats();
+    dprintf("Split link: %lu transactions, %lu errors, %u fallbacks, %uus round trip, speed step %u\n", (unsigned long)stats->transactions, (unsigned long)stats->errors, stats->fallbacks, stats->round_trip_us, stats->speed_step);
+}
+#else
+static inline void split_print_link_stats(void) {}
+#endif
+
 volatile bool isLeftHand = true;
 
 static struct {
@@ -113,6 +130,7 @@ bool split_watchdog_check(void) {
 void split_watchdog_task(void) {
     if (!split_watchdog_done && !is_keyboard_master()) {
         if (timer_elapsed32(split_watchdog_started) > SPLIT_WATCHDOG_TIMEOUT) {
+            split_print_link_stats();
             mcu_reset();
         }
     }
@@ -212,6 +230,10 @@ void split_pre_init(void) {
     }
 #endif
 
+#ifdef SPLIT_MATRIX_ATTENTION_PIN
+    split_matrix_attention_init(is_keyboard_master());
+#endif // SPLIT_MATRIX_ATTENTION_PIN
+
     if (is_keyboard_master()) {
         transport_master_init();
     }
@@ -245,6 +267,13 @@ bool transport_master_if_connected(matrix_row_t master_matrix[], matrix_row_t sl
 #endif // SPLIT_MAX_CONNECTION_ERRORS > 0 && SPLIT_CONNECTION_CHECK_TIMEOUT > 0
 
     __attribute__((unused)) bool okay = transport_master(master_matrix, slave_matrix);
+#if SPLIT_LINK_STATS_PRINT_INTERVAL > 0
+    static uint32_t link_stats_timer = 0;
+    if (timer_elapsed32(link_stats_timer) >= SPLIT_LINK_STATS_PRINT_INTERVAL) {
+        link_stats_timer = timer_read32();
+        split_print_link_stats();
+    }
+#endif // SPLIT_LINK_STATS_PRINT_INTERVAL > 0
 #if SPLIT_MAX_CONNECTION_ERRORS > 0
     if (!okay) {
         if (connection_errors < UINT8_MAX) {
@@ -255,6 +284,7 @@ bool transport_master_if_connected(matrix_row_t master_matrix[], matrix_row_t sl
         if (!connected) {
             connection_check_timer = timer_read();
             dprintln("Target disconnected, throttling connection attempts");
+            split_print_link_stats();
         }
         return connected;
     } else if (is_disconnected) {
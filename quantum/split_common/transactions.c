@@ -21,6 +21,7 @@
 #include "debug.h"
 #include "matrix.h"
 #include "host.h"
+#include "keyboard.h"
 #include "action_util.h"
 #include "sync_timer.h"
 #include "wait.h"
@@ -29,6 +30,7 @@
 #include "transaction_id_define.h"
 #include "split_util.h"
 #include "synchronization_util.h"
+#include "gpio.h"
 
 #ifdef BACKLIGHT_ENABLE
 #    include "backlight.h"
@@ -173,11 +175,42 @@ inline static bool send_if_data_mismatch(int8_t trans_id, uint32_t *last_update,
 ////////////////////////////////////////////////////
 // Slave matrix
 
+#ifdef SPLIT_MATRIX_ATTENTION_PIN
+// The slave pulls the attention pin low whenever its matrix has changed, and
+// releases it once the master has read the new checksum. The master only
+// talks to the slave while the pin is low, or every FORCED_SYNC_THROTTLE_MS as
+// a keepalive, instead of polling the checksum on every scan.
+
+void split_matrix_attention_init(bool is_master) {
+    if (is_master) {
+        setPinInputHigh(SPLIT_MATRIX_ATTENTION_PIN);
+    } else {
+        setPinOutput(SPLIT_MATRIX_ATTENTION_PIN);
+        writePinHigh(SPLIT_MATRIX_ATTENTION_PIN);
+    }
+}
+
+static void slave_matrix_checksum_callback(uint8_t initiator2target_buffer_size, const void *initiator2target_buffer, uint8_t target2initiator_buffer_size, void *target2initiator_buffer) {
+    writePinHigh(SPLIT_MATRIX_ATTENTION_PIN);
+}
+
+#    define SLAVE_MATRIX_CHECKSUM_CALLBACK slave_matrix_checksum_callback
+#else
+#    define SLAVE_MATRIX_CHECKSUM_CALLBACK NULL
+#endif // SPLIT_MATRIX_ATTENTION_PIN
+
 static bool slave_matrix_handlers_master(matrix_row_t master_matrix[], matrix_row_t slave_matrix[]) {
     static uint32_t     last_update                    = 0;
     static matrix_row_t last_matrix[(MATRIX_ROWS) / 2] = {0}; // last successfully-read matrix, so we can replicate if there are checksum errors
     matrix_row_t        temp_matrix[(MATRIX_ROWS) / 2];       // holding area while we test whether or not checksum is correct
 
+#ifdef SPLIT_MATRIX_ATTENTION_PIN
+    if (readPin(SPLIT_MATRIX_ATTENTION_PIN) && timer_elapsed32(last_update) < FORCED_SYNC_THROTTLE_MS) {
+        memcpy(slave_matrix, last_matrix, sizeof(last_matrix));
+        return true;
+    }
+#endif // SPLIT_MATRIX_ATTENTION_PIN
+
     bool okay = read_if_checksum_mismatch(GET_SLAVE_MATRIX_CHECKSUM, GET_SLAVE_MATRIX_DATA, &last_update, temp_matrix, split_shmem->smatrix.matrix, sizeof(split_shmem->smatrix.matrix));
     if (okay) {
         // Checksum matches the received data, save as the last matrix state
@@ -189,15 +222,25 @@ static bool slave_matrix_handlers_master(matrix_row_t master_matrix[], matrix_ro
 }
 
 static void slave_matrix_handlers_slave(matrix_row_t master_matrix[], matrix_row_t slave_matrix[]) {
+#ifdef SPLIT_MATRIX_ATTENTION_PIN
+    static bool checksum_valid = false;
+    if (checksum_valid && memcmp(split_shmem->smatrix.matrix, slave_matrix, sizeof(split_shmem->smatrix.matrix)) == 0) {
+        return;
+    }
+    checksum_valid = true;
+#endif // SPLIT_MATRIX_ATTENTION_PIN
     memcpy(split_shmem->smatrix.matrix, slave_matrix, sizeof(split_shmem->smatrix.matrix));
     split_shmem->smatrix.checksum = crc8(split_shmem->smatrix.matrix, sizeof(split_shmem->smatrix.matrix));
+#ifdef SPLIT_MATRIX_ATTENTION_PIN
+    writePinLow(SPLIT_MATRIX_ATTENTION_PIN);
+#endif // SPLIT_MATRIX_ATTENTION_PIN
 }
 
 // clang-format off
 #define TRANSACTIONS_SLAVE_MATRIX_MASTER() TRANSACTION_HANDLER_MASTER(slave_matrix)
 #define TRANSACTIONS_SLAVE_MATRIX_SLAVE() TRANSACTION_HANDLER_SLAVE_AUTOLOCK(slave_matrix)
 #define TRANSACTIONS_SLAVE_MATRIX_REGISTRATIONS \
-    [GET_SLAVE_MATRIX_CHECKSUM] = trans_target2initiator_initializer(smatrix.checksum), \
+    [GET_SLAVE_MATRIX_CHECKSUM] = trans_target2initiator_initializer_cb(smatrix.checksum, SLAVE_MATRIX_CHECKSUM_CALLBACK), \
     [GET_SLAVE_MATRIX_DATA]     = trans_target2initiator_initializer(smatrix.matrix),
 // clang-format on
 
@@ -520,12 +563,18 @@ static bool led_matrix_handlers_master(matrix_row_t master_matrix[], matrix_row_
 }
 
 static void led_matrix_handlers_slave(matrix_row_t master_matrix[], matrix_row_t slave_matrix[]) {
+    led_matrix_sync_t led_matrix_sync;
     split_shared_memory_lock();
-    memcpy(&led_matrix_eeconfig, &split_shmem->led_matrix_sync.led_matrix, sizeof(led_eeconfig_t));
-    bool led_suspend_state = split_shmem->led_matrix_sync.led_suspend_state;
+    memcpy(&led_matrix_sync, &split_shmem->led_matrix_sync, sizeof(led_matrix_sync_t));
     split_shared_memory_unlock();
 
-    led_matrix_set_suspend_state(led_suspend_state);
+    memcpy(&led_matrix_eeconfig, &led_matrix_sync.led_matrix, sizeof(led_eeconfig_t));
+    // Suspending flushes the LEDs, only hold up the render thread when that changes
+    if (led_matrix_get_suspend_state() != led_matrix_sync.led_suspend_state) {
+        threaded_tasks_lock();
+        led_matrix_set_suspend_state(led_matrix_sync.led_suspend_state);
+        threaded_tasks_unlock();
+    }
 }
 
 #    define TRANSACTIONS_LED_MATRIX_MASTER() TRANSACTION_HANDLER_MASTER(led_matrix)
@@ -554,12 +603,18 @@ static bool rgb_matrix_handlers_master(matrix_row_t master_matrix[], matrix_row_
 }
 
 static void rgb_matrix_handlers_slave(matrix_row_t master_matrix[], matrix_row_t slave_matrix[]) {
+    rgb_matrix_sync_t rgb_matrix_sync;
     split_shared_memory_lock();
-    memcpy(&rgb_matrix_config, &split_shmem->rgb_matrix_sync.rgb_matrix, sizeof(rgb_config_t));
-    bool rgb_suspend_state = split_shmem->rgb_matrix_sync.rgb_suspend_state;
+    memcpy(&rgb_matrix_sync, &split_shmem->rgb_matrix_sync, sizeof(rgb_matrix_sync_t));
     split_shared_memory_unlock();
 
-    rgb_matrix_set_suspend_state(rgb_suspend_state);
+    memcpy(&rgb_matrix_config, &rgb_matrix_sync.rgb_matrix, sizeof(rgb_config_t));
+    // Suspending flushes the LEDs, only hold up the render thread when that changes
+    if (rgb_matrix_get_suspend_state() != rgb_matrix_sync.rgb_suspend_state) {
+        threaded_tasks_lock();
+        rgb_matrix_set_suspend_state(rgb_matrix_sync.rgb_suspend_state);
+        threaded_tasks_unlock();
+    }
 }
 
 #    define TRANSACTIONS_RGB_MATRIX_MASTER() TRANSACTION_HANDLER_MASTER(rgb_matrix)
@@ -617,11 +672,16 @@ static void oled_handlers_slave(matrix_row_t master_matrix[], matrix_row_t slave
     uint8_t current_oled_state = split_shmem->current_oled_state;
     split_shared_memory_unlock();
 
+    // Switching the display talks to it, keep the render thread out while that happens.
+    // Calling oled_on() when already on only restarts its timeout.
+    bool switching = current_oled_state != is_oled_on();
+    if (switching) threaded_tasks_lock();
     if (current_oled_state) {
         oled_on();
     } else {
         oled_off();
     }
+    if (switching) threaded_tasks_unlock();
 }
 
 #    define TRANSACTIONS_OLED_MASTER() TRANSACTION_HANDLER_MASTER(oled)
@@ -652,11 +712,16 @@ static void st7565_handlers_slave(matrix_row_t master_matrix[], matrix_row_t sla
     uint8_t current_st7565_state = split_shmem->current_st7565_state;
     split_shared_memory_unlock();
 
+    // Switching the display talks to it, keep the render thread out while that happens.
+    // Calling st7565_on() when already on only restarts its timeout.
+    bool switching = current_st7565_state != st7565_is_on();
+    if (switching) threaded_tasks_lock();
     if (current_st7565_state) {
         st7565_on();
     } else {
         st7565_off();
     }
+    if (switching) threaded_tasks_unlock();
 }
 
 #    define TRANSACTIONS_ST7565_MASTER() TRANSACTION_HANDLER_MASTER(st7565)
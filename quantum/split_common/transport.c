@@ -21,6 +21,7 @@
 #include "transport.h"
 #include "transaction_id_define.h"
 #include "atomic_util.h"
+#include "basic_profiling.h"
 
 #ifdef USE_I2C
 
@@ -122,9 +123,9 @@ bool transport_execute_transaction(int8_t id, const void *initiator2target_buf,
 #endif // USE_I2C
 
 bool transport_master(matrix_row_t master_matrix[], matrix_row_t slave_matrix[]) {
-    return transactions_master(master_matrix, slave_matrix);
+    return PROFILE_ZONE_EXPR("split_transactions_master", transactions_master(master_matrix, slave_matrix));
 }
 
 void transport_slave(matrix_row_t master_matrix[], matrix_row_t slave_matrix[]) {
-    transactions_slave(master_matrix, slave_matrix);
+    PROFILE_ZONE("split_transactions_slave", transactions_slave(master_matrix, slave_matrix));
 }
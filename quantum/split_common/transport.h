@@ -34,6 +34,10 @@
 void transport_master_init(void);
 void transport_slave_init(void);
 
+#ifdef SPLIT_MATRIX_ATTENTION_PIN
+void split_matrix_attention_init(bool is_master);
+#endif // SPLIT_MATRIX_ATTENTION_PIN
+
 // returns false if valid data not received from slave
 bool transport_master(matrix_row_t master_matrix[], matrix_row_t slave_matrix[]);
 void transport_slave(matrix_row_t master_matrix[], matrix_row_t slave_matrix[]);
@@ -0,0 +1,76 @@
+// Copyright 2023 QMK
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "task_scheduler.h"
+#include "basic_profiling.h"
+#include "print.h"
+#include "timer.h"
+
+static scheduled_task_t *tasks        = NULL;
+static uint32_t          frame_begin  = 0;
+static uint32_t          budget_ticks = 0;
+
+void task_scheduler_frame_start(void) {
+    if (TASK_SCHEDULER_BUDGET && !budget_ticks) {
+        budget_ticks = (uint64_t)TASK_SCHEDULER_BUDGET * profile_timestamp_frequency() / 1000000;
+    }
+    frame_begin = profile_timestamp();
+}
+
+bool task_scheduler_begin(scheduled_task_t *task) {
+    uint32_t now    = timer_read32();
+    uint32_t waited = TIMER_DIFF_32(now, task->last_run);
+
+    if (!task->linked) {
+        // First call, run straight away
+        task->next   = tasks;
+        task->linked = true;
+        tasks        = task;
+    } else if (waited < task->interval) {
+        return false;
+    } else if (profile_timestamp() - frame_begin >= budget_ticks) {
+        if (waited < (uint32_t)task->interval + TASK_SCHEDULER_DEADLINE) {
+            task->deferred++;
+            return false;
+        }
+        task->late++;
+    }
+
+    task->last_run = now;
+    task->start    = profile_timestamp();
+    return true;
+}
+
+void task_scheduler_end(scheduled_task_t *task) {
+    uint32_t end   = profile_timestamp();
+    uint32_t ticks = end - task->start;
+
+    task->runs++;
+    if (ticks > task->max_ticks) {
+        task->max_ticks = ticks;
+    }
+    // Only blame the task that crossed the budget, not the ones forced through after it
+    if (task->start - frame_begin < budget_ticks && end - frame_begin >= budget_ticks) {
+        task->overruns++;
+    }
+}
+
+scheduled_task_t *task_scheduler_tasks(void) {
+    return tasks;
+}
+
+void task_scheduler_print(void) {
+    for (scheduled_task_t *task = tasks; task; task = task->next) {
+        xprintf("scheduler: %s runs %lu deferred %lu late %lu overruns %lu max %lu\n", task->name, (unsigned long)task->runs, (unsigned long)task->deferred, (unsigned long)task->late, (unsigned long)task->overruns, (unsigned long)task->max_ticks);
+    }
+}
+
+void task_scheduler_reset(void) {
+    for (scheduled_task_t *task = tasks; task; task = task->next) {
+        task->runs      = 0;
+        task->deferred  = 0;
+        task->late      = 0;
+        task->overruns  = 0;
+        task->max_ticks = 0;
+    }
+}
@@ -0,0 +1,106 @@
+// Copyright 2023 QMK
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+/*
+    Keeps deferrable work from delaying the next matrix scan.
+
+    keyboard_task() starts a frame with task_scheduler_frame_start(), scans the
+    matrix and runs everything that produces reports, then runs the deferrable
+    tasks (LED frames, displays, console flushes) inside
+    SCHEDULED_TASK(). A scheduled task runs once at least `interval`
+    milliseconds have passed since its last run, and only while less than
+    TASK_SCHEDULER_BUDGET microseconds of the frame have been used. A task
+    that has been waiting TASK_SCHEDULER_DEADLINE milliseconds past its
+    interval runs regardless, so nothing starves.
+
+        SCHEDULED_TASK("my_display_task", 50, my_display_task());
+
+    Each task counts the frames it was deferred, the times it had to be forced
+    through by its deadline and the times it pushed the frame over budget.
+    task_scheduler_tasks() walks them, for example to print them to the
+    console.
+
+    Without TASK_SCHEDULER_ENABLE, SCHEDULED_TASK() expands to just the call.
+*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef TASK_SCHEDULER_BUDGET
+#    define TASK_SCHEDULER_BUDGET 1000
+#endif
+
+#ifndef TASK_SCHEDULER_DEADLINE
+#    define TASK_SCHEDULER_DEADLINE 50
+#endif
+
+// Target periods of the core's deferrable tasks, in milliseconds. Zero runs
+// them every loop the budget allows, the tasks already limit their own frame
+// rate.
+#ifndef RGBLIGHT_TASK_INTERVAL
+#    define RGBLIGHT_TASK_INTERVAL 0
+#endif
+#ifndef LED_MATRIX_TASK_INTERVAL
+#    define LED_MATRIX_TASK_INTERVAL 0
+#endif
+#ifndef RGB_MATRIX_TASK_INTERVAL
+#    define RGB_MATRIX_TASK_INTERVAL 0
+#endif
+#ifndef OLED_TASK_INTERVAL
+#    define OLED_TASK_INTERVAL 0
+#endif
+#ifndef ST7565_TASK_INTERVAL
+#    define ST7565_TASK_INTERVAL 0
+#endif
+#ifndef CONSOLE_TRACE_TASK_INTERVAL
+#    define CONSOLE_TRACE_TASK_INTERVAL 0
+#endif
+#ifndef PROFILE_ZONES_TASK_INTERVAL
+#    define PROFILE_ZONES_TASK_INTERVAL 0
+#endif
+
+typedef struct scheduled_task_t {
+    const char *             name;
+    struct scheduled_task_t *next;
+    bool                     linked;
+    uint16_t                 interval;
+    uint32_t                 last_run;
+    uint32_t                 start;
+    uint32_t                 runs;
+    uint32_t                 deferred;
+    uint32_t                 late;
+    uint32_t                 overruns;
+    uint32_t                 max_ticks;
+} scheduled_task_t;
+
+/** \brief Marks the start of a main loop iteration, which the budget is measured from. */
+void task_scheduler_frame_start(void);
+
+/** \brief Returns true if the task should run now, in which case task_scheduler_end() must follow it. */
+bool task_scheduler_begin(scheduled_task_t *task);
+
+void task_scheduler_end(scheduled_task_t *task);
+
+/** \brief Returns the first task that has been scheduled, the rest follow through `next`. */
+scheduled_task_t *task_scheduler_tasks(void);
+
+void task_scheduler_print(void);
+
+void task_scheduler_reset(void);
+
+#ifdef TASK_SCHEDULER_ENABLE
+#    define SCHEDULED_TASK(task_name, task_interval, call)                                                \
+        do {                                                                                              \
+            static scheduled_task_t scheduled_task_ = {.name = (task_name), .interval = (task_interval)}; \
+            if (task_scheduler_begin(&scheduled_task_)) {                                                 \
+                call;                                                                                     \
+                task_scheduler_end(&scheduled_task_);                                                     \
+            }                                                                                             \
+        } while (0)
+#else
+#    define SCHEDULED_TASK(task_name, task_interval, call) \
+        do {                                               \
+            call;                                          \
+        } while (0)
+#endif
@@ -22,6 +22,7 @@
 #    error "DYNAMIC_KEYMAP_ENABLE is not enabled"
 #endif
 
+#include <string.h>
 #include "via.h"
 
 #include "raw_hid.h"
@@ -32,6 +33,7 @@
 #include "timer.h"
 #include "wait.h"
 #include "version.h" // for QMK_BUILDDATE used in EEPROM magic
+#include "util.h"
 
 #if defined(AUDIO_ENABLE)
 #    include "audio.h"
@@ -269,6 +271,135 @@ __attribute__((weak)) void via_custom_value_command(uint8_t *data, uint8_t lengt
     via_custom_value_command_kb(data, length);
 }
 
+#if VIA_STREAM_BUFFER_SIZE < 64
+#    error VIA_STREAM_BUFFER_SIZE must hold at least one full raw HID packet
+#elif VIA_STREAM_BUFFER_SIZE > 255
+#    error VIA_STREAM_BUFFER_SIZE must be at most 255 bytes
+#endif
+
+static struct {
+    uint16_t offset;    // where via_stream_buffer goes in the keymap buffer
+    uint16_t remaining; // bytes the host has yet to send
+    uint16_t sum;
+    uint8_t  fill;
+    uint8_t  seq;
+    bool     active;
+} via_stream;
+
+static uint8_t via_stream_buffer[VIA_STREAM_BUFFER_SIZE];
+
+static void via_fletcher16_update(uint16_t *sum, const uint8_t *data, uint8_t length) {
+    uint16_t sum1 = *sum & 0xFF;
+    uint16_t sum2 = *sum >> 8;
+    for (uint8_t i = 0; i < length; i++) {
+        sum1 += data[i];
+        if (sum1 >= 255) {
+            sum1 -= 255;
+        }
+        sum2 += sum1;
+        if (sum2 >= 255) {
+            sum2 -= 255;
+        }
+    }
+    *sum = (sum2 << 8) | sum1;
+}
+
+static void via_stream_get_buffer(uint8_t *data, uint8_t length) {
+    // data = [ command_id, offset_hi, offset_lo, size_hi, size_lo ]
+    uint16_t offset  = (data[1] << 8) | data[2];
+    uint16_t size    = (data[3] << 8) | data[4];
+    uint8_t  payload = length - 2;
+    uint16_t sum     = 0;
+    uint8_t  seq     = 0;
+
+    // Every packet is queued straight away, the host acks nothing
+    while (size > 0) {
+        uint8_t chunk = MIN(payload, size);
+        data[1]       = seq++;
+        dynamic_keymap_get_buffer(offset, chunk, &data[2]);
+        memset(&data[2 + chunk], 0x00, payload - chunk);
+        via_fletcher16_update(&sum, &data[2], chunk);
+        raw_hid_send(data, length);
+        offset += chunk;
+        size -= chunk;
+    }
+
+    data[1] = seq;
+    data[2] = sum >> 8;
+    data[3] = sum & 0xFF;
+    memset(&data[4], 0x00, length - 4);
+    raw_hid_send(data, length);
+}
+
+static void via_stream_flush(void) {
+    dynamic_keymap_set_buffer(via_stream.offset, via_stream.fill, via_stream_buffer);
+    via_stream.offset += via_stream.fill;
+    via_stream.fill = 0;
+}
+
+// Returns false for data packets within a window, which are not answered.
+static bool via_stream_set_buffer(uint8_t *data, uint8_t length) {
+    // data = [ command_id, operation, operation_data ]
+    uint8_t *operation = &(data[1]);
+
+    switch (*operation) {
+        case id_stream_begin: {
+            via_stream.offset    = (data[2] << 8) | data[3];
+            via_stream.remaining = (data[4] << 8) | data[5];
+            via_stream.sum       = 0;
+            via_stream.fill      = 0;
+            via_stream.seq       = 0;
+            via_stream.active    = true;
+            break;
+        }
+        case id_stream_data: {
+            // data = [ command_id, operation, seq, payload ]
+            if (!via_stream.active || data[2] != via_stream.seq) {
+                *operation = id_stream_error;
+                data[2]    = via_stream.seq;
+                break;
+            }
+            uint8_t size = MIN(length - 3, via_stream.remaining);
+            if (via_stream.fill + size > sizeof(via_stream_buffer)) {
+                via_stream_flush();
+            }
+            memcpy(&via_stream_buffer[via_stream.fill], &data[3], size);
+            via_fletcher16_update(&via_stream.sum, &data[3], size);
+            via_stream.fill += size;
+            via_stream.remaining -= size;
+            via_stream.seq++;
+            if (via_stream.seq % VIA_STREAM_WINDOW != 0 && via_stream.remaining > 0) {
+                return false;
+            }
+            // Commit the window before acking it
+            via_stream_flush();
+            break;
+        }
+        case id_stream_end: {
+            // data = [ command_id, operation, sum_hi, sum_lo ]
+            uint16_t sum = (data[2] << 8) | data[3];
+            if (via_stream.active) {
+                via_stream_flush();
+            }
+            if (!via_stream.active || via_stream.remaining > 0) {
+                data[2] = id_stream_incomplete;
+            } else if (sum != via_stream.sum) {
+                data[2] = id_stream_bad_sum;
+            } else {
+                data[2] = id_stream_ok;
+            }
+            via_stream.active = false;
+            break;
+        }
+        default: {
+            *operation = id_stream_error;
+            data[2]    = via_stream.seq;
+            break;
+        }
+    }
+    return true;
+}
+
 // Keyboard level code can override this, but shouldn't need to.
 // Controlling custom features should be done by overriding
 // via_custom_value_command_kb() instead.
@@ -436,6 +567,17 @@ void raw_hid_receive(uint8_t *data, uint8_t length) {
             dynamic_keymap_set_buffer(offset, size, &command_data[3]);
             break;
         }
+        case id_dynamic_keymap_stream_get_buffer: {
+            // Sends its own packets
+            via_stream_get_buffer(data, length);
+            return;
+        }
+        case id_dynamic_keymap_stream_set_buffer: {
+            if (!via_stream_set_buffer(data, length)) {
+                return;
+            }
+            break;
+        }
 #ifdef ENCODER_MAP_ENABLE
         case id_dynamic_keymap_get_encoder: {
             uint16_t keycode = dynamic_keymap_get_encoder(command_data[0], command_data[1], command_data[2] != 0);
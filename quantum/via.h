@@ -57,9 +57,20 @@
 
 #define VIA_EEPROM_CONFIG_END (VIA_EEPROM_CUSTOM_CONFIG_ADDR + VIA_EEPROM_CUSTOM_CONFIG_SIZE)
 
+// Number of stream set packets the host may send before waiting for an ack
+#ifndef VIA_STREAM_WINDOW
+#    define VIA_STREAM_WINDOW 4
+#endif
+
+// RAM used to gather stream set packets into fewer EEPROM updates, the
+// buffer is written out when it fills up and at the end of each window
+#ifndef VIA_STREAM_BUFFER_SIZE
+#    define VIA_STREAM_BUFFER_SIZE 128
+#endif
+
 // This is changed only when the command IDs change,
 // so VIA Configurator can detect compatible firmware.
-#define VIA_PROTOCOL_VERSION 0x000C
+#define VIA_PROTOCOL_VERSION 0x000D
 
 // This is a version number for the firmware for the keyboard.
 // It can be used to ensure the VIA keyboard definition and the firmware
@@ -93,9 +104,50 @@ enum via_command_id {
     id_dynamic_keymap_set_buffer            = 0x13,
     id_dynamic_keymap_get_encoder           = 0x14,
     id_dynamic_keymap_set_encoder           = 0x15,
+    id_dynamic_keymap_stream_get_buffer     = 0x16,
+    id_dynamic_keymap_stream_set_buffer     = 0x17,
     id_unhandled                            = 0xFF,
 };
 
+// Streaming keymap transfers move the whole keymap buffer with one packet
+// per RAW_EPSIZE report instead of one request and reply per 28 bytes.
+// Firmware without them answers id_unhandled, so hosts can fall back to
+// id_dynamic_keymap_get_buffer/id_dynamic_keymap_set_buffer.
+//
+// Stream get:
+//   host   [ 0x16, offset_hi, offset_lo, size_hi, size_lo ]
+//   device [ 0x16, seq, payload... ]           for seq = 0 .. count - 1
+//   device [ 0x16, count, sum_hi, sum_lo ]
+// with RAW_EPSIZE - 2 payload bytes per packet and a Fletcher-16 sum over
+// the whole transfer. Sequence numbers wrap around after 255.
+//
+// Stream set:
+//   host   [ 0x17, begin, offset_hi, offset_lo, size_hi, size_lo ]
+//   device [ 0x17, begin ]
+//   host   [ 0x17, data, seq, payload... ]     for seq = 0 .. count - 1
+//   device [ 0x17, data, seq ]                 after every VIA_STREAM_WINDOW packets and the last one
+//   host   [ 0x17, end, sum_hi, sum_lo ]
+//   device [ 0x17, end, status ]
+// with RAW_EPSIZE - 3 payload bytes per packet. The host may keep up to
+// VIA_STREAM_WINDOW data packets in flight before waiting for an ack.
+// Packets arriving out of sequence are answered with
+// [ 0x17, error, expected_seq ] and the host resends from there. Every
+// window is written to EEPROM before it is acked, so a bad sum or an
+// incomplete transfer leaves a partly written keymap behind that the host
+// should send again.
+enum via_stream_operation {
+    id_stream_begin = 0x00,
+    id_stream_data  = 0x01,
+    id_stream_end   = 0x02,
+    id_stream_error = 0xFF,
+};
+
+enum via_stream_status {
+    id_stream_ok         = 0x00,
+    id_stream_bad_sum    = 0x01,
+    id_stream_incomplete = 0x02,
+};
+
 enum via_keyboard_value_id {
     id_uptime              = 0x01,
     id_layout_options      = 0x02,
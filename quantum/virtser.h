@@ -1,5 +1,8 @@
 #pragma once
 
+#include <stdint.h>
+#include <stdbool.h>
+
 void virtser_init(void);
 
 /* Define this function in your code to process incoming bytes */
@@ -7,3 +10,11 @@ void virtser_recv(const uint8_t ch);
 
 /* Call this to send a character over the Virtual Serial Device */
 void virtser_send(const uint8_t byte);
+
+/* Queue a whole packet for sending, or none of it if there is not enough room.
+ * Returns false if the packet has to be retried later.
+ */
+bool virtser_send_packet(const uint8_t *data, uint8_t length);
+
+/* Number of bytes virtser_send() had to drop because the host stopped reading */
+uint16_t virtser_dropped(void);
@@ -20,7 +20,7 @@
 #include "keycode.h"
 #include "quantum_keycodes.h"
 #include "action_util.h"
-#include <math.h>
+#include <string.h>
 
 // WPM Stuff
 static uint8_t  current_wpm = 0;
@@ -28,19 +28,32 @@ static uint32_t wpm_timer   = 0;
 
 /* The WPM calculation works by specifying a certain number of 'periods' inside
  * a ring buffer, and we count the number of keypresses which occur in each of
- * those periods.  Then to calculate WPM, we add up all of the keypresses in
+ * those periods.  Then to calculate WPM, we take the number of keypresses in
  * the whole ring buffer, divide by the number of keypresses in a 'word', and
  * then adjust for how much time is captured by our ring buffer.  The size
  * of the ring buffer can be configured using the keymap configuration
  * value `WPM_SAMPLE_PERIODS`.
  *
+ * A running total of the ring buffer is maintained as keypresses are added and
+ * periods expire, so both updating and decaying are constant time regardless
+ * of the number of periods configured.
  */
 #define MAX_PERIODS (WPM_SAMPLE_PERIODS)
 #define PERIOD_DURATION (1000 * WPM_SAMPLE_SECONDS / MAX_PERIODS)
 
-static int16_t period_presses[MAX_PERIODS] = {0};
-static uint8_t current_period              = 0;
-static uint8_t periods                     = 1;
+_Static_assert(PERIOD_DURATION > 0, "WPM_SAMPLE_PERIODS is too large for WPM_SAMPLE_SECONDS");
+
+#if MAX_PERIODS > UINT8_MAX
+typedef uint16_t wpm_period_t;
+#else
+typedef uint8_t wpm_period_t;
+#endif
+
+static int16_t      period_presses[MAX_PERIODS] = {0};
+static int32_t      presses_total               = 0;
+static wpm_period_t current_period              = 0;
+static wpm_period_t periods                     = 1;
+static uint32_t     last_decay                  = 0;
 
 #if !defined(WPM_UNFILTERED)
 /* LATENCY is used as part of filtering, and controls how quickly the reported
@@ -58,6 +71,52 @@ static uint8_t  prev_wpm        = 0;
 static uint8_t  next_wpm        = 0;
 #endif
 
+#if defined(WPM_INTERVAL_HISTOGRAM)
+/* The interval histogram counts the time between consecutive WPM-counted
+ * keypresses, in buckets of `WPM_INTERVAL_HISTOGRAM_BIN_MS` milliseconds.
+ * The last bucket also collects every interval longer than the histogram
+ * covers.  Counts saturate rather than wrap.
+ */
+static uint16_t interval_histogram[WPM_INTERVAL_HISTOGRAM_BINS] = {0};
+static uint32_t last_press_time                                 = 0;
+static bool     last_press_valid                                = false;
+
+static void record_interval(void) {
+    uint32_t now = timer_read32();
+    if (last_press_valid) {
+        uint32_t bin = TIMER_DIFF_32(now, last_press_time) / WPM_INTERVAL_HISTOGRAM_BIN_MS;
+        if (bin >= WPM_INTERVAL_HISTOGRAM_BINS) {
+            bin = WPM_INTERVAL_HISTOGRAM_BINS - 1;
+        }
+        if (interval_histogram[bin] < UINT16_MAX) {
+            interval_histogram[bin]++;
+        }
+    }
+    last_press_time  = now;
+    last_press_valid = true;
+}
+
+uint16_t wpm_interval_histogram_get(uint8_t bin) {
+    return bin < WPM_INTERVAL_HISTOGRAM_BINS ? interval_histogram[bin] : 0;
+}
+
+uint8_t wpm_interval_histogram_read(uint16_t *dest, uint8_t offset, uint8_t count) {
+    if (offset >= WPM_INTERVAL_HISTOGRAM_BINS) {
+        return 0;
+    }
+    if (count > WPM_INTERVAL_HISTOGRAM_BINS - offset) {
+        count = WPM_INTERVAL_HISTOGRAM_BINS - offset;
+    }
+    memcpy(dest, &interval_histogram[offset], count * sizeof(uint16_t));
+    return count;
+}
+
+void wpm_interval_histogram_clear(void) {
+    memset(interval_histogram, 0, sizeof(interval_histogram));
+    last_press_valid = false;
+}
+#endif
+
 void set_current_wpm(uint8_t new_wpm) {
     current_wpm = new_wpm;
 }
@@ -110,42 +169,66 @@ __attribute__((weak)) uint8_t wpm_regress_count(uint16_t keycode) {
 // Outside 'raw' mode we smooth results over time.
 
 void update_wpm(uint16_t keycode) {
-    if (wpm_keycode(keycode) && period_presses[current_period] < INT16_MAX) {
-        period_presses[current_period]++;
+    if (wpm_keycode(keycode)) {
+        if (period_presses[current_period] < INT16_MAX) {
+            period_presses[current_period]++;
+            presses_total++;
+        }
+#if defined(WPM_INTERVAL_HISTOGRAM)
+        record_interval();
+#endif
     }
 #if defined(WPM_ALLOW_COUNT_REGRESSION)
     uint8_t regress = wpm_regress_count(keycode);
     if (regress && period_presses[current_period] > INT16_MIN) {
         period_presses[current_period]--;
+        presses_total--;
     }
 #endif
 }
 
-void decay_wpm(void) {
-    int32_t presses = period_presses[0];
-    for (int i = 1; i <= periods; i++) {
-        presses += period_presses[i];
+static uint8_t calculate_wpm(uint32_t elapsed) {
+    if (presses_total < 2) { // don't guess high WPM based on a single keypress.
+        return 0;
     }
-    if (presses < 0) {
-        presses = 0;
+    uint32_t duration = (((uint32_t)periods * PERIOD_DURATION) + elapsed);
+    uint32_t wpm_now  = (60000 * (uint32_t)presses_total) / (duration * WPM_ESTIMATED_WORD_SIZE);
+
+    if (wpm_now > 240) wpm_now = 240; // set some reasonable WPM measurement limits
+    return wpm_now;
+}
+
+void decay_wpm(void) {
+    uint32_t now = timer_read32();
+    // Nothing below changes within the same millisecond, so skip the work.
+    if (now == last_decay) {
+        return;
     }
-    int32_t  elapsed  = timer_elapsed32(wpm_timer);
-    uint32_t duration = (((periods)*PERIOD_DURATION) + elapsed);
-    int32_t  wpm_now  = (60000 * presses) / (duration * WPM_ESTIMATED_WORD_SIZE);
+    last_decay = now;
 
-    if (wpm_now < 0) // set some reasonable WPM measurement limits
-        wpm_now = 0;
-    if (wpm_now > 240) wpm_now = 240;
+    uint32_t elapsed = TIMER_DIFF_32(now, wpm_timer);
+
+#if defined(WPM_UNFILTERED)
+    current_wpm = calculate_wpm(elapsed);
+#else
+    uint32_t latency = TIMER_DIFF_32(now, smoothing_timer);
+    if (latency > LATENCY) {
+        smoothing_timer = now;
+        prev_wpm        = current_wpm;
+        next_wpm        = calculate_wpm(elapsed);
+        latency         = 0;
+    }
+#endif
 
     if (elapsed > PERIOD_DURATION) {
-        current_period                 = (current_period + 1) % MAX_PERIODS;
+        if (++current_period >= MAX_PERIODS) {
+            current_period = 0;
+        }
+        presses_total -= period_presses[current_period];
         period_presses[current_period] = 0;
         periods                        = (periods < MAX_PERIODS - 1) ? periods + 1 : MAX_PERIODS - 1;
-        elapsed                        = 0;
-        wpm_timer                      = timer_read32();
+        wpm_timer                      = now;
     }
-    if (presses < 2) // don't guess high WPM based on a single keypress.
-        wpm_now = 0;
 
 #if defined(WPM_LAUNCH_CONTROL)
     /*
@@ -155,24 +238,15 @@ void decay_wpm(void) {
      * immediately reach the correct value even before a full sampling buffer
      * has been filled.
      */
-    if (presses == 0) {
-        current_period    = 0;
-        periods           = 0;
-        wpm_now           = 0;
-        period_presses[0] = 0;
+    if (presses_total < 0 || (presses_total == 0 && (periods != 0 || current_period != 0))) {
+        memset(period_presses, 0, sizeof(period_presses));
+        presses_total  = 0;
+        current_period = 0;
+        periods        = 0;
     }
 #endif // WPM_LAUNCH_CONTROL
 
-#if defined(WPM_UNFILTERED)
-    current_wpm = wpm_now;
-#else
-    int32_t latency = timer_elapsed32(smoothing_timer);
-    if (latency > LATENCY) {
-        smoothing_timer = timer_read32();
-        prev_wpm        = current_wpm;
-        next_wpm        = wpm_now;
-    }
-
-    current_wpm = prev_wpm + (latency * ((int)next_wpm - (int)prev_wpm) / LATENCY);
+#if !defined(WPM_UNFILTERED)
+    current_wpm = prev_wpm + ((int32_t)latency * ((int)next_wpm - (int)prev_wpm) / LATENCY);
 #endif
 }
@@ -30,6 +30,15 @@
 #    define WPM_SAMPLE_PERIODS 25
 #endif
 
+#ifdef WPM_INTERVAL_HISTOGRAM
+#    ifndef WPM_INTERVAL_HISTOGRAM_BINS
+#        define WPM_INTERVAL_HISTOGRAM_BINS 16
+#    endif
+#    ifndef WPM_INTERVAL_HISTOGRAM_BIN_MS
+#        define WPM_INTERVAL_HISTOGRAM_BIN_MS 25
+#    endif
+#endif
+
 bool wpm_keycode(uint16_t keycode);
 bool wpm_keycode_kb(uint16_t keycode);
 bool wpm_keycode_user(uint16_t keycode);
@@ -43,3 +52,9 @@ uint8_t get_current_wpm(void);
 void    update_wpm(uint16_t);
 
 void decay_wpm(void);
+
+#ifdef WPM_INTERVAL_HISTOGRAM
+uint16_t wpm_interval_histogram_get(uint8_t bin);
+uint8_t  wpm_interval_histogram_read(uint16_t *dest, uint8_t offset, uint8_t count);
+void     wpm_interval_histogram_clear(void);
+#endif
@@ -14,3 +14,6 @@
 # along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 AUDIO_ENABLE = yes
+
+# The synthesizer is only linked for the dac_additive driver, test it directly
+SRC += $(QUANTUM_DIR)/audio/synth.c
@@ -0,0 +1,172 @@
+// Copyright 2024 QMK
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+extern "C" {
+#include "synth.h"
+}
+
+namespace {
+
+constexpr uint32_t kSampleRate = 24000;
+constexpr uint16_t kSampleMax  = 4095;
+constexpr uint16_t kOffValue   = kSampleMax / 2;
+
+class SynthTest : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        audio_synth_init(kSampleRate, kSampleMax, kOffValue);
+        audio_synth_set_waveform(AUDIO_SYNTH_WAVEFORM_SINE);
+    }
+
+    std::vector<uint16_t> render(size_t length) {
+        std::vector<uint16_t> buffer(length);
+        audio_synth_render(buffer.data(), length);
+        return buffer;
+    }
+
+    void play(std::vector<float> frequencies) {
+        audio_synth_set_tones(frequencies.data(), frequencies.data(), frequencies.size());
+    }
+
+    static int max_step(const std::vector<uint16_t> &buffer) {
+        int step = 0;
+        for (size_t i = 1; i < buffer.size(); i++) {
+            step = std::max(step, std::abs(buffer[i] - buffer[i - 1]));
+        }
+        return step;
+    }
+};
+
+TEST_F(SynthTest, SilenceIsOffValue) {
+    EXPECT_FALSE(audio_synth_is_active());
+    for (uint16_t sample : render(128)) {
+        EXPECT_EQ(sample, kOffValue);
+    }
+}
+
+TEST_F(SynthTest, SineHasRequestedPeriod) {
+    // 1kHz at 24kHz is exactly 24 samples per period
+    play({1000.0f});
+    render(kSampleRate / 100); // past the attack
+
+    auto buffer = render(240);
+    for (size_t i = 0; i + 24 < buffer.size(); i++) {
+        EXPECT_NEAR(buffer[i], buffer[i + 24], 2) << "sample " << i;
+    }
+    EXPECT_NEAR(*std::max_element(buffer.begin(), buffer.end()), kSampleMax, 32);
+    EXPECT_NEAR(*std::min_element(buffer.begin(), buffer.end()), 0, 32);
+}
+
+TEST_F(SynthTest, AttackAndReleaseDoNotStep) {
+    // a full scale 100Hz sine moves at most ~54 per sample, the envelope adds
+    // at most the amplitude spread over the ramp duration
+    const int slope   = kOffValue * 2 * 314 / 100 * 100 / kSampleRate + 1;
+    const int attack  = kOffValue / (kSampleRate * AUDIO_SYNTH_ATTACK_MS / 1000) + 1;
+    const int release = kOffValue / (kSampleRate * AUDIO_SYNTH_RELEASE_MS / 1000) + 1;
+
+    play({100.0f});
+    EXPECT_LE(max_step(render(kSampleRate / 10)), slope + attack);
+
+    play({});
+    auto faded = render(kSampleRate / 10);
+    EXPECT_LE(max_step(faded), slope + release);
+    EXPECT_EQ(faded.back(), kOffValue);
+    EXPECT_FALSE(audio_synth_is_active());
+}
+
+TEST_F(SynthTest, VoicesAreMixedAdditively) {
+    const size_t settle = kSampleRate / 10;
+
+    play({440.0f});
+    render(settle);
+    auto a = render(256);
+
+    SetUp();
+    play({660.0f});
+    render(settle);
+    auto b = render(256);
+
+    SetUp();
+    play({440.0f, 660.0f});
+    render(settle);
+    auto mixed = render(256);
+
+    for (size_t i = 0; i < mixed.size(); i++) {
+        int expected = kOffValue + ((a[i] - kOffValue) + (b[i] - kOffValue)) / 2;
+        EXPECT_NEAR(mixed[i], expected, 2) << "sample " << i;
+    }
+}
+
+TEST_F(SynthTest, PitchBendKeepsPhase) {
+    const float pitch = 440.0f;
+    float       frequency;
+
+    frequency = 440.0f;
+    audio_synth_set_tones(&pitch, &frequency, 1);
+    render(kSampleRate / 10);
+    auto before = render(16);
+
+    // same tone, slightly different frequency (vibrato): the waveform continues smoothly
+    frequency = 445.0f;
+    audio_synth_set_tones(&pitch, &frequency, 1);
+    auto after = render(16);
+
+    EXPECT_LE(std::abs(after.front() - before.back()), max_step(before) + 2);
+    EXPECT_TRUE(audio_synth_is_active());
+}
+
+TEST_F(SynthTest, StoppedToneFadesWhileOthersContinue) {
+    play({440.0f, 660.0f});
+    render(kSampleRate / 10);
+
+    play({660.0f});
+    render(kSampleRate / 10);
+    auto remaining = render(256);
+
+    SetUp();
+    play({660.0f});
+    render(kSampleRate / 10);
+    auto alone = render(256);
+
+    // once the released voice has faded, only the remaining tone is heard at full volume
+    for (size_t i = 0; i < remaining.size(); i++) {
+        EXPECT_NEAR(remaining[i], alone[i], 80) << "sample " << i;
+    }
+    EXPECT_NEAR(*std::max_element(remaining.begin(), remaining.end()), kSampleMax, 32);
+}
+
+TEST_F(SynthTest, CustomWavetable) {
+    int16_t table[AUDIO_SYNTH_WAVETABLE_LENGTH];
+    for (int i = 0; i < AUDIO_SYNTH_WAVETABLE_LENGTH; i++) {
+        table[i] = 16384;
+    }
+    audio_synth_set_wavetable(table);
+
+    play({1000.0f});
+    render(kSampleRate / 10);
+    for (uint16_t sample : render(64)) {
+        EXPECT_NEAR(sample, kOffValue + kSampleMax / 4, 2);
+    }
+
+    audio_synth_set_wavetable(NULL);
+}
+
+} // namespace
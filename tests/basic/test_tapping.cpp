@@ -190,3 +190,33 @@ TEST_F(Tapping, TapA_CTL_T_KeyWhileReleasingLayer) {
     run_one_scan_loop();
     VERIFY_AND_CLEAR(driver);
 }
+
+TEST_F(Tapping, NextDeadlineIsTheEndOfTheTappingTerm) {
+    TestDriver driver;
+    InSequence s;
+    auto       mod_tap_hold_key = KeymapKey(0, 7, 0, SFT_T(KC_P));
+
+    set_keymap({mod_tap_hold_key});
+
+    // Nothing waits on the timer while no key is held
+    EXPECT_EQ(keyboard_next_deadline(), TIMER_NO_DEADLINE);
+
+    mod_tap_hold_key.press();
+    EXPECT_NO_REPORT(driver);
+    run_one_scan_loop();
+    EXPECT_EQ(keyboard_next_deadline(), TAPPING_TERM - 1U);
+
+    idle_for(TAPPING_TERM - 1);
+    EXPECT_EQ(keyboard_next_deadline(), 0U);
+    VERIFY_AND_CLEAR(driver);
+
+    // The key turns into a hold once the tapping term is over
+    EXPECT_REPORT(driver, (KC_LSFT));
+    run_one_scan_loop();
+    EXPECT_EQ(keyboard_next_deadline(), TIMER_NO_DEADLINE);
+    VERIFY_AND_CLEAR(driver);
+
+    EXPECT_EMPTY_REPORT(driver);
+    mod_tap_hold_key.release();
+    run_one_scan_loop();
+}
@@ -0,0 +1,127 @@
+// Copyright 2023 QMK
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "keyboard_report_util.hpp"
+#include "keycode.h"
+#include "test_common.hpp"
+#include "test_fixture.hpp"
+#include "test_keymap_key.hpp"
+
+using testing::AnyNumber;
+using testing::AtLeast;
+
+// C++ does not allow the out of order designated initializers used by ko_make_basic()
+static key_override_t make_basic_override(uint8_t trigger_mods, uint16_t trigger, uint16_t replacement) {
+    key_override_t override  = {};
+    override.trigger         = trigger;
+    override.trigger_mods    = trigger_mods;
+    override.layers          = ~0;
+    override.suppressed_mods = trigger_mods;
+    override.replacement     = replacement;
+    override.options         = ko_options_default;
+    return override;
+}
+
+// Two overrides share the trigger KC_A, the first one in the array has to win.
+const key_override_t shift_a_override   = make_basic_override(MOD_MASK_SHIFT, KC_A, KC_B);
+const key_override_t shift_a_shadowed   = make_basic_override(MOD_MASK_SHIFT, KC_A, KC_C);
+const key_override_t ctrl_bspc_override = make_basic_override(MOD_MASK_CTRL, KC_BSPC, KC_DEL);
+const key_override_t gui_only_override  = make_basic_override(MOD_MASK_GUI, KC_NO, KC_ESC);
+
+const key_override_t *key_override_list[] = {
+    &shift_a_override,
+    &shift_a_shadowed,
+    &ctrl_bspc_override,
+    &gui_only_override,
+    NULL,
+};
+
+extern "C" {
+const key_override_t **key_overrides = key_override_list;
+}
+
+class KeyOverride : public TestFixture {};
+
+TEST_F(KeyOverride, FirstMatchingOverrideInArrayActivates) {
+    TestDriver driver;
+    KeymapKey  key_shift(0, 0, 0, KC_LSFT);
+    KeymapKey  key_a(0, 1, 0, KC_A);
+
+    set_keymap({key_shift, key_a});
+
+    EXPECT_REPORT(driver, (KC_LSFT));
+    key_shift.press();
+    run_one_scan_loop();
+    VERIFY_AND_CLEAR(driver);
+
+    EXPECT_REPORT(driver, (KC_B));
+    key_a.press();
+    run_one_scan_loop();
+    VERIFY_AND_CLEAR(driver);
+
+    EXPECT_REPORT(driver, (KC_LSFT)).Times(AnyNumber());
+    EXPECT_EMPTY_REPORT(driver).Times(AnyNumber());
+    key_a.release();
+    run_one_scan_loop();
+    key_shift.release();
+    run_one_scan_loop();
+    VERIFY_AND_CLEAR(driver);
+}
+
+TEST_F(KeyOverride, OverrideOnlyActivatesForItsTrigger) {
+    TestDriver driver;
+    KeymapKey  key_ctrl(0, 0, 0, KC_LCTL);
+    KeymapKey  key_a(0, 1, 0, KC_A);
+    KeymapKey  key_bspc(0, 2, 0, KC_BSPC);
+
+    set_keymap({key_ctrl, key_a, key_bspc});
+
+    EXPECT_REPORT(driver, (KC_LCTL));
+    key_ctrl.press();
+    run_one_scan_loop();
+    VERIFY_AND_CLEAR(driver);
+
+    EXPECT_REPORT(driver, (KC_LCTL, KC_A));
+    key_a.press();
+    run_one_scan_loop();
+    VERIFY_AND_CLEAR(driver);
+
+    EXPECT_REPORT(driver, (KC_LCTL));
+    key_a.release();
+    run_one_scan_loop();
+    VERIFY_AND_CLEAR(driver);
+
+    EXPECT_REPORT(driver, (KC_DEL));
+    key_bspc.press();
+    run_one_scan_loop();
+    VERIFY_AND_CLEAR(driver);
+
+    EXPECT_REPORT(driver, (KC_LCTL)).Times(AnyNumber());
+    EXPECT_EMPTY_REPORT(driver).Times(AnyNumber());
+    key_bspc.release();
+    run_one_scan_loop();
+    key_ctrl.release();
+    run_one_scan_loop();
+    VERIFY_AND_CLEAR(driver);
+}
+
+TEST_F(KeyOverride, OverrideWithoutTriggerActivatesOnModifier) {
+    TestDriver driver;
+    KeymapKey  key_gui(0, 0, 0, KC_LGUI);
+
+    set_keymap({key_gui});
+
+    EXPECT_REPORT(driver, (KC_LGUI)).Times(AnyNumber());
+    EXPECT_EMPTY_REPORT(driver).Times(AnyNumber());
+    EXPECT_REPORT(driver, (KC_ESC)).Times(AtLeast(1));
+    key_gui.press();
+    run_one_scan_loop();
+    idle_for(500);
+    VERIFY_AND_CLEAR(driver);
+
+    EXPECT_REPORT(driver, (KC_LGUI)).Times(AnyNumber());
+    EXPECT_EMPTY_REPORT(driver).Times(AnyNumber());
+    key_gui.release();
+    run_one_scan_loop();
+    VERIFY_AND_CLEAR(driver);
+}
@@ -0,0 +1,5 @@
+# Copyright 2023 QMK
+# SPDX-License-Identifier: GPL-2.0-or-later
+
+PROFILE_ZONES_ENABLE = yes
+CAPS_WORD_ENABLE = yes
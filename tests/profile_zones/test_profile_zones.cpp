@@ -0,0 +1,71 @@
+// Copyright 2023 QMK
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include <numeric>
+#include <string>
+#include "keycode.h"
+#include "test_common.hpp"
+
+extern "C" {
+#include "basic_profiling.h"
+}
+
+using testing::_;
+
+namespace {
+
+profile_zone_t* find_zone(const std::string& name) {
+    for (profile_zone_t* zone = profile_zones(); zone; zone = zone->next) {
+        if (name == zone->name) {
+            return zone;
+        }
+    }
+    return nullptr;
+}
+
+} // namespace
+
+class ProfileZones : public TestFixture {
+   protected:
+    void SetUp() override {
+        profile_zones_reset();
+    }
+};
+
+TEST_F(ProfileZones, key_tap_enters_every_stage) {
+    TestDriver driver;
+    auto       key = KeymapKey(0, 0, 0, KC_A);
+    set_keymap({key});
+
+    EXPECT_ANY_REPORT(driver).Times(2);
+    tap_key(key);
+    VERIFY_AND_CLEAR(driver);
+
+    for (auto name : {"matrix_scan", "action_exec", "process_record_quantum", "process_record_kb", "process_caps_word"}) {
+        profile_zone_t* zone = find_zone(name);
+        ASSERT_NE(zone, nullptr) << name;
+        EXPECT_GT(zone->count, 0u) << name;
+        EXPECT_LE(zone->min, zone->max) << name;
+        EXPECT_EQ(std::accumulate(zone->histogram, zone->histogram + PROFILE_HISTOGRAM_BUCKETS, 0u), zone->count) << name;
+    }
+
+    // One press and one release
+    EXPECT_EQ(find_zone("action_exec")->count, 2u);
+    EXPECT_EQ(find_zone("process_caps_word")->count, 2u);
+}
+
+TEST_F(ProfileZones, reset_clears_zones) {
+    TestDriver driver;
+    auto       key = KeymapKey(0, 0, 0, KC_A);
+    set_keymap({key});
+
+    EXPECT_ANY_REPORT(driver).Times(2);
+    tap_key(key);
+    VERIFY_AND_CLEAR(driver);
+
+    profile_zones_reset();
+    for (profile_zone_t* zone = profile_zones(); zone; zone = zone->next) {
+        EXPECT_EQ(zone->count, 0u) << zone->name;
+        EXPECT_EQ(zone->total, 0u) << zone->name;
+    }
+}
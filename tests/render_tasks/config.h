@@ -0,0 +1,11 @@
+// Copyright 2023 QMK
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include "test_common.h"
+
+#define LED_MATRIX_LED_COUNT 2
+#define LED_MATRIX_KEYPRESSES
+#define ENABLE_LED_MATRIX_SOLID_REACTIVE_SIMPLE
+#define LED_MATRIX_DEFAULT_MODE LED_MATRIX_SOLID_REACTIVE_SIMPLE
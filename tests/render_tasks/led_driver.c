@@ -0,0 +1,46 @@
+// Copyright 2023 QMK
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "quantum.h"
+
+uint8_t led_values[LED_MATRIX_LED_COUNT];
+
+static void test_led_init(void) {}
+
+static void test_led_set_value(int index, uint8_t value) {
+    led_values[index] = value;
+}
+
+static void test_led_set_value_all(uint8_t value) {
+    for (uint8_t i = 0; i < LED_MATRIX_LED_COUNT; i++) {
+        led_values[i] = value;
+    }
+}
+
+static void test_led_flush(void) {}
+
+const led_matrix_driver_t led_matrix_driver = {
+    .init          = test_led_init,
+    .set_value     = test_led_set_value,
+    .set_value_all = test_led_set_value_all,
+    .flush         = test_led_flush,
+};
+
+// clang-format off
+led_config_t g_led_config = {
+    {
+        {      0,      1, NO_LED, NO_LED, NO_LED, NO_LED, NO_LED, NO_LED, NO_LED, NO_LED },
+        { NO_LED, NO_LED, NO_LED, NO_LED, NO_LED, NO_LED, NO_LED, NO_LED, NO_LED, NO_LED },
+        { NO_LED, NO_LED, NO_LED, NO_LED, NO_LED, NO_LED, NO_LED, NO_LED, NO_LED, NO_LED },
+        { NO_LED, NO_LED, NO_LED, NO_LED, NO_LED, NO_LED, NO_LED, NO_LED, NO_LED, NO_LED },
+    },
+    { { 0, 0 }, { 224, 0 } },
+    { LED_FLAG_KEYLIGHT, LED_FLAG_KEYLIGHT },
+};
+// clang-format on
+
+void led_driver_reset(void) {
+    led_matrix_mode_noeeprom(LED_MATRIX_SOLID_REACTIVE_SIMPLE);
+    led_matrix_set_val_noeeprom(LED_MATRIX_MAXIMUM_BRIGHTNESS);
+    led_matrix_enable_noeeprom();
+}
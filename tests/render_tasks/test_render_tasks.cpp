@@ -0,0 +1,90 @@
+// Copyright 2023 QMK
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "keycode.h"
+#include "test_common.hpp"
+
+extern "C" {
+#include "keyboard.h"
+extern uint8_t led_values[LED_MATRIX_LED_COUNT];
+void           led_driver_reset(void);
+void           advance_time(uint32_t ms);
+}
+
+using testing::_;
+
+// Long enough for the LED engine to sync, render and flush a frame
+constexpr uint8_t FRAME_MS = 20;
+
+class RenderTasks : public TestFixture {
+   protected:
+    void SetUp() override {
+        TestDriver driver;
+        EXPECT_NO_REPORT(driver);
+        led_driver_reset();
+        // Let any earlier hit fade out
+        idle_for(1000);
+    }
+};
+
+TEST_F(RenderTasks, KeyboardTaskRendersSwitchEvents) {
+    TestDriver driver;
+    auto       key = KeymapKey(0, 0, 0, KC_A);
+
+    set_keymap({key});
+
+    key.press();
+    EXPECT_REPORT(driver, (key.report_code));
+    run_one_scan_loop();
+    idle_for(FRAME_MS);
+    EXPECT_GT(led_values[0], 0);
+    EXPECT_EQ(led_values[1], 0);
+
+    key.release();
+    EXPECT_EMPTY_REPORT(driver);
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
+
+TEST_F(RenderTasks, RenderEntryPointsWorkWithoutKeyboardTask) {
+    TestDriver driver;
+    EXPECT_NO_REPORT(driver);
+
+    // The render thread only calls these two, the scan never runs
+    keyboard_render_switch_event(0, 1, true);
+    for (uint8_t i = 0; i < FRAME_MS; i++) {
+        advance_time(1);
+        keyboard_render_task();
+    }
+    EXPECT_EQ(led_values[0], 0);
+    EXPECT_GT(led_values[1], 0);
+    keyboard_render_switch_event(0, 1, false);
+}
+
+TEST_F(RenderTasks, ConfigChangesApplyFromTheNextFrame) {
+    TestDriver driver;
+    EXPECT_NO_REPORT(driver);
+
+    // Run until the first of the two LEDs has been drawn
+    led_matrix_mode_noeeprom(LED_MATRIX_SOLID);
+    for (uint8_t i = 0; i < FRAME_MS && led_values[0] == 0; i++) {
+        advance_time(1);
+        keyboard_render_task();
+    }
+    ASSERT_GT(led_values[0], 0);
+    ASSERT_EQ(led_values[1], 0);
+
+    // A keycode may change the flags while the render thread is mid-frame
+    led_matrix_set_flags_noeeprom(LED_FLAG_NONE);
+    keyboard_render_task();
+    EXPECT_GT(led_values[0], 0);
+    EXPECT_GT(led_values[1], 0);
+
+    for (uint8_t i = 0; i < FRAME_MS; i++) {
+        advance_time(1);
+        keyboard_render_task();
+    }
+    EXPECT_EQ(led_values[0], 0);
+    EXPECT_EQ(led_values[1], 0);
+    led_matrix_set_flags_noeeprom(LED_FLAG_ALL);
+}
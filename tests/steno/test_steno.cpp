@@ -0,0 +1,112 @@
+// Copyright 2023 QMK
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include <vector>
+#include "keycode.h"
+#include "test_common.hpp"
+
+extern "C" {
+#include "process_steno.h"
+}
+
+using testing::_;
+
+namespace {
+
+/* Stands in for the CDC transmit queue, which either accepts a whole packet or none of it. */
+bool                              host_accepts_packets = true;
+std::vector<std::vector<uint8_t>> host_packets;
+
+const std::vector<uint8_t> stroke_s_a = {0x80, 0x40, 0x20, 0x00, 0x00, 0x00};
+const std::vector<uint8_t> stroke_t_a = {0x80, 0x10, 0x20, 0x00, 0x00, 0x00};
+
+} // namespace
+
+extern "C" {
+void virtser_init(void) {}
+
+void virtser_send(const uint8_t byte) {
+    host_packets.push_back({byte});
+}
+
+bool virtser_send_packet(const uint8_t *data, uint8_t length) {
+    if (!host_accepts_packets) {
+        return false;
+    }
+    host_packets.emplace_back(data, data + length);
+    return true;
+}
+}
+
+class Steno : public TestFixture {
+   protected:
+    KeymapKey key_s = KeymapKey(0, 0, 0, STN_S1);
+    KeymapKey key_t = KeymapKey(0, 1, 0, STN_TL);
+    KeymapKey key_a = KeymapKey(0, 2, 0, STN_A);
+
+    void SetUp() override {
+        set_keymap({key_s, key_t, key_a});
+        host_accepts_packets = true;
+        host_packets.clear();
+    }
+
+    void chord(KeymapKey first, KeymapKey second) {
+        first.press();
+        run_one_scan_loop();
+        second.press();
+        run_one_scan_loop();
+        first.release();
+        run_one_scan_loop();
+        second.release();
+        run_one_scan_loop();
+    }
+};
+
+TEST_F(Steno, stroke_is_sent_as_one_packet) {
+    TestDriver driver;
+    EXPECT_NO_REPORT(driver);
+
+    chord(key_s, key_a);
+
+    ASSERT_EQ(host_packets.size(), 1);
+    EXPECT_EQ(host_packets[0], stroke_s_a);
+    VERIFY_AND_CLEAR(driver);
+}
+
+TEST_F(Steno, strokes_wait_for_the_host_in_order) {
+    TestDriver driver;
+    EXPECT_NO_REPORT(driver);
+    auto stats = steno_get_stroke_stats();
+
+    host_accepts_packets = false;
+    chord(key_s, key_a);
+    chord(key_t, key_a);
+    idle_for(10);
+    EXPECT_TRUE(host_packets.empty());
+    EXPECT_EQ(steno_get_stroke_stats().delayed - stats.delayed, 2);
+
+    host_accepts_packets = true;
+    run_one_scan_loop();
+    ASSERT_EQ(host_packets.size(), 2);
+    EXPECT_EQ(host_packets[0], stroke_s_a);
+    EXPECT_EQ(host_packets[1], stroke_t_a);
+    EXPECT_EQ(steno_get_stroke_stats().dropped, stats.dropped);
+    VERIFY_AND_CLEAR(driver);
+}
+
+TEST_F(Steno, strokes_are_dropped_when_the_buffer_is_full) {
+    TestDriver driver;
+    EXPECT_NO_REPORT(driver);
+    auto stats = steno_get_stroke_stats();
+
+    host_accepts_packets = false;
+    for (int i = 0; i < 5; i++) {
+        chord(key_s, key_a);
+    }
+    EXPECT_EQ(steno_get_stroke_stats().dropped - stats.dropped, 1);
+
+    host_accepts_packets = true;
+    run_one_scan_loop();
+    EXPECT_EQ(host_packets.size(), 4);
+    VERIFY_AND_CLEAR(driver);
+}
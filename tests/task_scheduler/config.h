@@ -0,0 +1,11 @@
+// Copyright 2023 QMK
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include "test_common.h"
+
+// Every frame is over budget, so scheduled tasks only run on their deadline
+#define TASK_SCHEDULER_BUDGET 0
+#define TASK_SCHEDULER_DEADLINE 20
+#define PROFILE_ZONES_PRINT_INTERVAL 0
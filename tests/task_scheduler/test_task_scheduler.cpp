@@ -0,0 +1,118 @@
+// Copyright 2023 QMK
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include <string>
+#include "keycode.h"
+#include "test_common.hpp"
+
+extern "C" {
+#include "task_scheduler.h"
+void advance_time(uint32_t ms);
+}
+
+using testing::_;
+
+namespace {
+
+int deferrable_runs = 0;
+int periodic_runs   = 0;
+
+void deferrable_task(void) {
+    SCHEDULED_TASK("deferrable_task", 0, deferrable_runs++);
+}
+
+void periodic_task(void) {
+    SCHEDULED_TASK("periodic_task", 10, periodic_runs++);
+}
+
+scheduled_task_t* find_task(const std::string& name) {
+    for (scheduled_task_t* task = task_scheduler_tasks(); task; task = task->next) {
+        if (name == task->name) {
+            return task;
+        }
+    }
+    return nullptr;
+}
+
+void run_frames(void (*task)(void), unsigned ms) {
+    for (unsigned i = 0; i < ms; i++) {
+        advance_time(1);
+        task_scheduler_frame_start();
+        task();
+    }
+}
+
+} // namespace
+
+class TaskScheduler : public TestFixture {
+   protected:
+    void SetUp() override {
+        task_scheduler_reset();
+    }
+};
+
+TEST_F(TaskScheduler, over_budget_task_waits_for_its_deadline) {
+    deferrable_runs = 0;
+    task_scheduler_frame_start();
+    deferrable_task();
+    EXPECT_EQ(deferrable_runs, 1);
+
+    run_frames(deferrable_task, TASK_SCHEDULER_DEADLINE - 1);
+    EXPECT_EQ(deferrable_runs, 1);
+
+    run_frames(deferrable_task, 1);
+    EXPECT_EQ(deferrable_runs, 2);
+
+    scheduled_task_t* task = find_task("deferrable_task");
+    ASSERT_NE(task, nullptr);
+    EXPECT_EQ(task->runs, 2u);
+    EXPECT_EQ(task->deferred, TASK_SCHEDULER_DEADLINE - 1u);
+    EXPECT_EQ(task->late, 1u);
+}
+
+TEST_F(TaskScheduler, interval_is_not_counted_as_deferral) {
+    periodic_runs = 0;
+    task_scheduler_frame_start();
+    periodic_task();
+    EXPECT_EQ(periodic_runs, 1);
+
+    run_frames(periodic_task, 9);
+    scheduled_task_t* task = find_task("periodic_task");
+    ASSERT_NE(task, nullptr);
+    EXPECT_EQ(task->deferred, 0u);
+
+    run_frames(periodic_task, TASK_SCHEDULER_DEADLINE);
+    EXPECT_EQ(periodic_runs, 1);
+    EXPECT_EQ(task->deferred, (uint32_t)TASK_SCHEDULER_DEADLINE);
+
+    run_frames(periodic_task, 1);
+    EXPECT_EQ(periodic_runs, 2);
+    EXPECT_EQ(task->late, 1u);
+}
+
+TEST_F(TaskScheduler, keys_are_handled_while_tasks_are_deferred) {
+    TestDriver driver;
+    auto       key = KeymapKey(0, 0, 0, KC_A);
+    set_keymap({key});
+
+    // Lets profile_zones_task run once, every later scan is over budget until its deadline
+    run_one_scan_loop();
+    scheduled_task_t* task = find_task("profile_zones_task");
+    ASSERT_NE(task, nullptr);
+    uint32_t runs     = task->runs;
+    uint32_t deferred = task->deferred;
+
+    EXPECT_REPORT(driver, (KC_A));
+    key.press();
+    run_one_scan_loop();
+    VERIFY_AND_CLEAR(driver);
+    EXPECT_EQ(task->runs, runs);
+    EXPECT_EQ(task->deferred, deferred + 1);
+
+    EXPECT_EMPTY_REPORT(driver);
+    key.release();
+    run_one_scan_loop();
+    VERIFY_AND_CLEAR(driver);
+    EXPECT_EQ(task->runs, runs);
+    EXPECT_EQ(task->deferred, deferred + 2);
+}
@@ -1,8 +1,10 @@
 #include "test_fixture.hpp"
 #include <algorithm>
+#include <chrono>
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
+#include <sstream>
 #include "gmock/gmock-cardinalities.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -171,12 +173,60 @@ void TestFixture::run_one_scan_loop() {
     this->idle_for(1);
 }
 
+/* Runs the keyboard task for `time` milliseconds. Between loops virtual time
+ * jumps straight to the next deadline the firmware reports, the loops in
+ * between could not change anything as the matrix does not change here. */
 void TestFixture::idle_for(unsigned time) {
     test_logger.trace() << +time << " keyboard task " << (time > 1 ? "loops" : "loop") << std::endl;
-    for (unsigned i = 0; i < time; i++) {
+    for (unsigned elapsed = 0; elapsed < time;) {
         keyboard_task();
+        uint32_t step = std::min<uint32_t>(std::max<uint32_t>(keyboard_next_deadline(), 1), time - elapsed);
+        advance_time(step);
+        elapsed += step;
+    }
+}
+
+TraceResult TestFixture::replay_trace(TestDriver& driver, const std::vector<TraceEvent>& trace, unsigned settle_ms) {
+    TraceResult result;
+    uint32_t    start = timer_read32();
+
+    EXPECT_ANY_REPORT(driver).WillRepeatedly([&](const report_keyboard_t& report) {
+        std::stringstream text;
+        text << report;
+        /* Drop the "report:" label and the trailing newline. */
+        auto line = text.str().substr(text.str().find_first_not_of(' ', 7));
+        result.reports.push_back({timer_elapsed32(start), line.substr(0, line.find_last_not_of('\n') + 1)});
+    });
+
+    for (size_t i = 0; i < trace.size();) {
+        uint32_t now = timer_elapsed32(start);
+        if (trace[i].time > now) {
+            idle_for(trace[i].time - now);
+        }
+
+        size_t first = i;
+        for (; i < trace.size() && trace[i].time == trace[first].time; i++) {
+            if (trace[i].pressed) {
+                press_key(trace[i].col, trace[i].row);
+            } else {
+                release_key(trace[i].col, trace[i].row);
+            }
+        }
+
+        auto begin = std::chrono::steady_clock::now();
+        keyboard_task();
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin);
         advance_time(1);
+
+        result.event_ns.insert(result.event_ns.end(), i - first, elapsed.count());
     }
+
+    /* Tap-hold and tap dance timeouts still send reports, which the expectation records. */
+    idle_for(settle_ms);
+    /* The expectation refers to locals of this frame, drop it before they go away. */
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    return result;
 }
 
 void TestFixture::print_test_log() const {
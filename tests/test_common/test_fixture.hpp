@@ -22,6 +22,9 @@
 #include "gtest/gtest.h"
 #include "keyboard.h"
 #include "test_keymap_key.hpp"
+#include "test_trace.hpp"
+
+class TestDriver;
 
 class TestFixture : public testing::Test {
    public:
@@ -63,6 +66,16 @@ class TestFixture : public testing::Test {
     void run_one_scan_loop();
     void idle_for(unsigned ms);
 
+    /**
+     * @brief Replays a recorded `trace` and records every keyboard report that `driver` receives.
+     *
+     * Events sharing a timestamp are applied in the same scan loop, which is timed
+     * for the per-event processing cost. The trace starts at the current time, and
+     * reports keep being recorded for `settle_ms` after the last event. The
+     * expectations on `driver` are cleared before returning.
+     */
+    TraceResult replay_trace(TestDriver& driver, const std::vector<TraceEvent>& trace, unsigned settle_ms);
+
     void expect_layer_state(layer_t layer) const;
 
    protected:
@@ -0,0 +1,146 @@
+// Copyright 2023 QMK
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "test_trace.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include "gtest/gtest.h"
+
+namespace {
+
+bool is_comment_or_empty(const std::string& line) {
+    auto first = line.find_first_not_of(" \t\r");
+    return first == std::string::npos || line[first] == '#';
+}
+
+} // namespace
+
+std::vector<TraceEvent> parse_trace(std::istream& input) {
+    std::vector<TraceEvent> trace;
+    std::string             line;
+    unsigned                line_number = 0;
+
+    while (std::getline(input, line)) {
+        line_number++;
+        if (is_comment_or_empty(line)) {
+            continue;
+        }
+
+        std::istringstream fields(line);
+        uint32_t           time;
+        unsigned           row, col;
+        std::string        state;
+        if (!(fields >> time >> row >> col >> state) || (state != "down" && state != "up")) {
+            ADD_FAILURE() << "malformed trace event in line " << line_number << ": " << line;
+            continue;
+        }
+        if (!trace.empty() && time < trace.back().time) {
+            ADD_FAILURE() << "trace event in line " << line_number << " goes back in time";
+            continue;
+        }
+
+        trace.push_back({time, static_cast<uint8_t>(row), static_cast<uint8_t>(col), state == "down"});
+    }
+
+    return trace;
+}
+
+std::vector<TraceEvent> load_trace(const std::string& path) {
+    std::ifstream input(path);
+    if (!input) {
+        ADD_FAILURE() << "unable to open trace " << path;
+        return {};
+    }
+    return parse_trace(input);
+}
+
+std::vector<TraceReport> parse_reports(std::istream& input) {
+    std::vector<TraceReport> reports;
+    std::string              line;
+
+    while (std::getline(input, line)) {
+        if (is_comment_or_empty(line)) {
+            continue;
+        }
+
+        std::istringstream fields(line);
+        TraceReport        report;
+        fields >> report.time >> std::ws;
+        std::getline(fields, report.report);
+        reports.push_back(report);
+    }
+
+    return reports;
+}
+
+std::vector<TraceReport> load_reports(const std::string& path) {
+    std::ifstream input(path);
+    if (!input) {
+        ADD_FAILURE() << "unable to open golden reports " << path;
+        return {};
+    }
+    return parse_reports(input);
+}
+
+void write_reports(std::ostream& output, const std::vector<TraceReport>& reports) {
+    for (auto& report : reports) {
+        output << report.time << " " << report.report << std::endl;
+    }
+}
+
+void expect_golden_reports(const std::vector<TraceReport>& actual, const std::string& path) {
+    if (std::getenv("QMK_UPDATE_GOLDEN")) {
+        std::ofstream output(path);
+        write_reports(output, actual);
+        return;
+    }
+
+    auto expected = load_reports(path);
+    for (size_t i = 0; i < std::max(expected.size(), actual.size()); i++) {
+        if (i >= expected.size()) {
+            ADD_FAILURE() << "unexpected report " << actual[i].time << " " << actual[i].report;
+        } else if (i >= actual.size()) {
+            ADD_FAILURE() << "missing report " << expected[i].time << " " << expected[i].report;
+        } else if (!(actual[i] == expected[i])) {
+            ADD_FAILURE() << "report " << i << " differs, expected " << expected[i].time << " " << expected[i].report << " but got " << actual[i].time << " " << actual[i].report;
+        } else {
+            continue;
+        }
+        /* Everything after the first difference is noise. */
+        return;
+    }
+}
+
+std::vector<TraceEvent> generate_random_trace(uint32_t seed, const std::vector<std::pair<uint8_t, uint8_t>>& keys, size_t events, uint32_t max_gap_ms) {
+    std::mt19937                            rng(seed);
+    std::uniform_int_distribution<uint32_t> gap(0, max_gap_ms);
+    std::vector<bool>                       pressed(keys.size(), false);
+    std::vector<TraceEvent>                 trace;
+    uint32_t                                time = 0;
+
+    for (size_t i = 0; i < events; i++) {
+        size_t key = std::uniform_int_distribution<size_t>(0, keys.size() - 1)(rng);
+        time += gap(rng);
+        pressed[key] = !pressed[key];
+        trace.push_back({time, keys[key].second, keys[key].first, pressed[key]});
+    }
+
+    for (size_t key = 0; key < keys.size(); key++) {
+        if (pressed[key]) {
+            time += gap(rng);
+            trace.push_back({time, keys[key].second, keys[key].first, false});
+        }
+    }
+
+    return trace;
+}
+
+std::ostream& operator<<(std::ostream& os, const std::vector<TraceEvent>& trace) {
+    for (auto& event : trace) {
+        os << event.time << " " << +event.row << " " << +event.col << " " << (event.pressed ? "down" : "up") << std::endl;
+    }
+    return os;
+}
@@ -0,0 +1,78 @@
+// Copyright 2023 QMK
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief A single matrix event of a recorded keystroke trace.
+ */
+struct TraceEvent {
+    uint32_t time; // ms since the start of the trace
+    uint8_t  row;
+    uint8_t  col;
+    bool     pressed;
+};
+
+/**
+ * @brief A keyboard report sent to the host while replaying a trace.
+ */
+struct TraceReport {
+    uint32_t    time; // ms since the start of the trace
+    std::string report;
+
+    bool operator==(const TraceReport& other) const {
+        return time == other.time && report == other.report;
+    }
+};
+
+/**
+ * @brief Everything observed while replaying a trace.
+ */
+struct TraceResult {
+    std::vector<TraceReport> reports;
+    /* Wall clock time of the scan loop that processed each event, in the order of the trace. */
+    std::vector<uint64_t> event_ns;
+};
+
+/**
+ * @brief Parses a trace, one "<time> <row> <col> <down|up>" event per line.
+ *
+ * Empty lines and lines starting with '#' are ignored, events must be sorted by time.
+ */
+std::vector<TraceEvent> parse_trace(std::istream& input);
+std::vector<TraceEvent> load_trace(const std::string& path);
+
+/**
+ * @brief Reads and writes a golden report stream, one "<time> <report>" entry per line.
+ */
+std::vector<TraceReport> parse_reports(std::istream& input);
+std::vector<TraceReport> load_reports(const std::string& path);
+void                     write_reports(std::ostream& output, const std::vector<TraceReport>& reports);
+
+/**
+ * @brief Compares the replayed report stream against the golden file at `path`.
+ *
+ * Setting the environment variable QMK_UPDATE_GOLDEN rewrites the golden file
+ * with `actual` instead of comparing it.
+ */
+void expect_golden_reports(const std::vector<TraceReport>& actual, const std::string& path);
+
+/**
+ * @brief Generates a reproducible random trace over `keys` (col, row pairs).
+ *
+ * Every pressed key is released again before the trace ends, so the keyboard
+ * has to settle back into its idle state once the trace was replayed.
+ */
+std::vector<TraceEvent> generate_random_trace(uint32_t seed, const std::vector<std::pair<uint8_t, uint8_t>>& keys, size_t events, uint32_t max_gap_ms);
+
+/**
+ * @brief Formats a trace in the format understood by parse_trace, used to print failing fuzz cases.
+ */
+std::ostream& operator<<(std::ostream& os, const std::vector<TraceEvent>& trace);
@@ -0,0 +1,64 @@
+// Copyright 2023 QMK
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include <algorithm>
+#include <cstdlib>
+#include <numeric>
+#include "keyboard_report_util.hpp"
+#include "keycode.h"
+#include "test_common.hpp"
+#include "test_trace.hpp"
+
+using testing::_;
+
+namespace {
+
+std::string test_dir() {
+    std::string file(__FILE__);
+    return file.substr(0, file.find_last_of('/') + 1);
+}
+
+/* Scale up with QMK_FUZZ_ITERATIONS for a longer fuzzing session. */
+unsigned fuzz_iterations() {
+    const char* iterations = std::getenv("QMK_FUZZ_ITERATIONS");
+    return iterations ? std::strtoul(iterations, nullptr, 10) : 200;
+}
+
+} // namespace
+
+class TraceReplay : public TestFixture {
+   protected:
+    void SetUp() override {
+        set_keymap({
+            KeymapKey(0, 0, 0, KC_A), KeymapKey(0, 1, 0, KC_B), KeymapKey(0, 2, 0, LSFT_T(KC_C)), KeymapKey(0, 3, 0, LT(1, KC_D)), KeymapKey(0, 4, 0, TD(0)), KeymapKey(0, 5, 0, KC_J), KeymapKey(0, 6, 0, KC_K),
+            KeymapKey(1, 0, 0, KC_1), KeymapKey(1, 1, 0, KC_2), KeymapKey(1, 2, 0, KC_TRNS), KeymapKey(1, 3, 0, KC_TRNS), KeymapKey(1, 4, 0, KC_TRNS), KeymapKey(1, 5, 0, KC_TRNS), KeymapKey(1, 6, 0, KC_TRNS),
+        });
+    }
+};
+
+TEST_F(TraceReplay, typing_matches_golden_reports) {
+    TestDriver driver;
+
+    auto trace  = load_trace(test_dir() + "typing.trace");
+    auto result = replay_trace(driver, trace, TAPPING_TERM * 2);
+
+    expect_golden_reports(result.reports, test_dir() + "typing.golden");
+
+    ASSERT_EQ(result.event_ns.size(), trace.size());
+    RecordProperty("max_event_ns", std::to_string(*std::max_element(result.event_ns.begin(), result.event_ns.end())));
+    RecordProperty("mean_event_ns", std::to_string(std::accumulate(result.event_ns.begin(), result.event_ns.end(), uint64_t{0}) / result.event_ns.size()));
+}
+
+TEST_F(TraceReplay, random_traces_settle_to_idle) {
+    TestDriver driver;
+
+    const std::vector<std::pair<uint8_t, uint8_t>> keys = {{0, 0}, {1, 0}, {2, 0}, {3, 0}, {4, 0}, {5, 0}, {6, 0}};
+
+    for (uint32_t seed = 0; seed < fuzz_iterations(); seed++) {
+        auto trace  = generate_random_trace(seed, keys, 40, TAPPING_TERM + 50);
+        auto result = replay_trace(driver, trace, TAPPING_TERM * 5);
+
+        bool settled = (result.reports.empty() || result.reports.back().report == "empty") && get_mods() == 0 && layer_state == 0;
+        ASSERT_TRUE(settled) << "keyboard did not return to idle after replaying seed " << seed << ":\n" << trace;
+    }
+}
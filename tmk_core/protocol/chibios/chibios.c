@@ -101,6 +101,88 @@ void midi_ep_task(void);
 //   }
 // }
 
+#ifdef THREADED_TASKS_ENABLE
+/* Render thread
+ * The main thread scans the matrix and sends reports, LED matrix and display
+ * frames are drawn by a lower priority thread that only runs while the main
+ * thread sleeps between scans. Switch events for the reactive effects are
+ * handed over through a mailbox. Keycodes only change the lighting config,
+ * which the LED engines latch at the start of each frame, so a keypress never
+ * waits for the render thread. The mutex only keeps the two threads off the
+ * LED and display drivers: the render thread holds it for each pass, the main
+ * thread takes it through threaded_tasks_lock() on USB suspend and wakeup, and
+ * when a split slave is told to suspend or switch its display on or off.
+ *
+ * The main thread only sleeps while a frame is due or in progress. Sleeps are
+ * rounded up to the system tick, so with the default 1 kHz tick each of these
+ * scans is delayed by up to a millisecond rather than INPUT_IDLE_US.
+ */
+#    ifndef THREADED_TASKS_RENDER_PRIORITY
+#        define THREADED_TASKS_RENDER_PRIORITY LOWPRIO
+#    endif
+#    ifndef THREADED_TASKS_RENDER_STACK_SIZE
+#        define THREADED_TASKS_RENDER_STACK_SIZE 1024
+#    endif
+#    ifndef THREADED_TASKS_RENDER_INTERVAL
+#        define THREADED_TASKS_RENDER_INTERVAL 1
+#    endif
+#    ifndef THREADED_TASKS_INPUT_IDLE_US
+#        define THREADED_TASKS_INPUT_IDLE_US 100
+#    endif
+#    ifndef THREADED_TASKS_EVENT_QUEUE_SIZE
+#        define THREADED_TASKS_EVENT_QUEUE_SIZE 16
+#    endif
+
+static msg_t render_events_buffer[THREADED_TASKS_EVENT_QUEUE_SIZE];
+static MAILBOX_DECL(render_events, render_events_buffer, THREADED_TASKS_EVENT_QUEUE_SIZE);
+static MUTEX_DECL(render_mutex);
+static uint8_t            render_lock_depth = 0;
+static volatile bool      render_idle       = false;
+static volatile systime_t render_frame_end;
+
+void threaded_tasks_lock(void) {
+    if (render_lock_depth++ == 0) {
+        chMtxLock(&render_mutex);
+    }
+}
+
+void threaded_tasks_unlock(void) {
+    if (--render_lock_depth == 0) {
+        chMtxUnlock(&render_mutex);
+    }
+}
+
+static bool threaded_tasks_render_pending(void) {
+    return !render_idle || chVTTimeElapsedSinceX(render_frame_end) >= TIME_MS2I(THREADED_TASKS_RENDER_INTERVAL);
+}
+
+void threaded_tasks_post_switch_event(uint8_t row, uint8_t col, bool pressed) {
+    // Never block the scan, a dropped event only costs a reactive effect
+    chMBPostTimeout(&render_events, (msg_t)(row << 16 | col << 8 | pressed), TIME_IMMEDIATE);
+}
+
+static THD_WORKING_AREA(waRenderThread, THREADED_TASKS_RENDER_STACK_SIZE);
+static THD_FUNCTION(RenderThread, arg) {
+    (void)arg;
+    chRegSetThreadName("render");
+
+    while (true) {
+        render_idle = false;
+        chMtxLock(&render_mutex);
+        msg_t event;
+        while (chMBFetchTimeout(&render_events, &event, TIME_IMMEDIATE) == MSG_OK) {
+            keyboard_render_switch_event((event >> 16) & 0xFF, (event >> 8) & 0xFF, event & 1);
+        }
+        keyboard_render_task();
+        chMtxUnlock(&render_mutex);
+
+        render_frame_end = chVTGetSystemTimeX();
+        render_idle      = true;
+        chThdSleepMilliseconds(THREADED_TASKS_RENDER_INTERVAL);
+    }
+}
+#endif // THREADED_TASKS_ENABLE
+
 /* Early initialisation
  */
 __attribute__((weak)) void early_hardware_init_pre(void) {
@@ -178,6 +260,10 @@ void protocol_pre_init(void) {
 
 void protocol_post_init(void) {
     host_set_driver(driver);
+
+#ifdef THREADED_TASKS_ENABLE
+    chThdCreateStatic(waRenderThread, sizeof(waRenderThread), THREADED_TASKS_RENDER_PRIORITY, RenderThread, NULL);
+#endif
 }
 
 void protocol_pre_task(void) {
@@ -186,6 +272,10 @@ void protocol_pre_task(void) {
 #if !defined(NO_USB_STARTUP_CHECK)
     if (USB_DRIVER.state == USB_SUSPENDED) {
         dprintln("suspending keyboard");
+#    ifdef THREADED_TASKS_ENABLE
+        // The suspend handlers run the LED tasks themselves, keep the render thread out
+        threaded_tasks_lock();
+#    endif
         while (USB_DRIVER.state == USB_SUSPENDED) {
             /* Do this in the suspended state */
             suspend_power_down(); // on AVR this deep sleeps for 15ms
@@ -194,6 +284,9 @@ void protocol_pre_task(void) {
                 usbWakeupHost(&USB_DRIVER);
             }
         }
+#    ifdef THREADED_TASKS_ENABLE
+        threaded_tasks_unlock();
+#    endif
         /* Woken up */
         // variables has been already cleared by the wakeup hook
         send_keyboard_report();
@@ -217,4 +310,10 @@ void protocol_post_task(void) {
 #ifdef RAW_ENABLE
     raw_hid_task();
 #endif
+#ifdef THREADED_TASKS_ENABLE
+    // Give the render thread its turn before the next scan, if it has a frame to draw
+    if (threaded_tasks_render_pending()) {
+        chThdSleepMicroseconds(THREADED_TASKS_INPUT_IDLE_US);
+    }
+#endif
 }
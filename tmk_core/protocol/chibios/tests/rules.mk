@@ -0,0 +1,7 @@
+usb_report_queue_INC := \
+	$(TMK_PATH)/protocol \
+	$(TMK_PATH)/protocol/chibios
+
+usb_report_queue_SRC := \
+	$(TMK_PATH)/protocol/chibios/tests/usb_report_queue_tests.cpp \
+	$(TMK_PATH)/protocol/chibios/usb_report_queue.c
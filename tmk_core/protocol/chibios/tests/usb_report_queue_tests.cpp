@@ -0,0 +1,98 @@
+// Copyright 2023 QMK
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include <vector>
+#include "gtest/gtest.h"
+
+extern "C" {
+#include "usb_report_queue.h"
+}
+
+class UsbReportQueue : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        queue = {};
+        usb_report_queue_reset(&queue);
+        sent.clear();
+    }
+
+    static report_keyboard_t key_report(uint8_t keycode) {
+        report_keyboard_t report = {};
+        report.keys[0]           = keycode;
+        return report;
+    }
+
+    // Queues a report, letting the host take one whenever the queue is full
+    void send(const report_keyboard_t &report, bool mergeable = true) {
+        while (!usb_report_queue_push(&queue, &report, sizeof(report), mergeable)) {
+            host_poll();
+        }
+    }
+
+    void host_poll() {
+        uint8_t       size;
+        usb_report_t *report = usb_report_queue_peek(&queue, &size);
+        ASSERT_NE(report, nullptr);
+        ASSERT_EQ(size, sizeof(report_keyboard_t));
+        sent.push_back(report->keyboard.keys[0]);
+        usb_report_queue_pop(&queue);
+    }
+
+    void host_drain() {
+        while (queue.count) {
+            host_poll();
+        }
+    }
+
+    usb_report_queue_t   queue;
+    std::vector<uint8_t> sent;
+};
+
+TEST_F(UsbReportQueue, MoreTapsThanQueueDepthAreAllSent) {
+    std::vector<uint8_t> expected;
+    for (uint8_t key = 4; key < 4 + USB_REPORT_QUEUE_DEPTH * 3; key++) {
+        send(key_report(key));
+        send(key_report(0));
+        expected.push_back(key);
+        expected.push_back(0);
+    }
+    host_drain();
+
+    EXPECT_EQ(sent, expected);
+    EXPECT_EQ(queue.stats.merged, 0u);
+    EXPECT_EQ(queue.stats.queued, expected.size());
+    EXPECT_EQ(queue.stats.max_depth, USB_REPORT_QUEUE_DEPTH);
+}
+
+TEST_F(UsbReportQueue, IdenticalReportIsMergedWhenFull) {
+    for (uint8_t i = 0; i < USB_REPORT_QUEUE_DEPTH; i++) {
+        report_keyboard_t report = key_report(4 + i);
+        ASSERT_TRUE(usb_report_queue_push(&queue, &report, sizeof(report), true));
+    }
+
+    report_keyboard_t newest = key_report(4 + USB_REPORT_QUEUE_DEPTH - 1);
+    report_keyboard_t other  = key_report(0);
+    EXPECT_TRUE(usb_report_queue_push(&queue, &newest, sizeof(newest), true));
+    EXPECT_FALSE(usb_report_queue_push(&queue, &other, sizeof(other), true));
+    EXPECT_EQ(queue.stats.merged, 1u);
+    EXPECT_EQ(queue.count, USB_REPORT_QUEUE_DEPTH);
+}
+
+TEST_F(UsbReportQueue, UnmergeableReportWaitsWhenIdentical) {
+    report_keyboard_t report = key_report(4);
+    for (uint8_t i = 0; i < USB_REPORT_QUEUE_DEPTH; i++) {
+        ASSERT_TRUE(usb_report_queue_push(&queue, &report, sizeof(report), false));
+    }
+    EXPECT_FALSE(usb_report_queue_push(&queue, &report, sizeof(report), false));
+    EXPECT_EQ(queue.stats.merged, 0u);
+}
+
+TEST_F(UsbReportQueue, ResetEmptiesTheQueue) {
+    send(key_report(4));
+    queue.in_flight = true;
+    usb_report_queue_reset(&queue);
+
+    uint8_t size;
+    EXPECT_EQ(usb_report_queue_peek(&queue, &size), nullptr);
+    EXPECT_FALSE(queue.in_flight);
+}
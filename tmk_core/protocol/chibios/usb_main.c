@@ -32,6 +32,7 @@
 #include "usb_main.h"
 
 #include "host.h"
+#include "keyboard.h"
 #include "chibios_config.h"
 #include "debug.h"
 #include "suspend.h"
@@ -44,6 +45,9 @@
 #include "usb_descriptor.h"
 #include "usb_driver.h"
 #include "usb_types.h"
+#ifdef CONSOLE_TRACE_ENABLE
+#    include "console_trace.h"
+#endif
 
 #ifdef NKRO_ENABLE
 #    include "keycode_config.h"
@@ -118,14 +122,144 @@ static const USBDescriptor *usb_get_descriptor_cb(USBDriver *usbp, uint8_t dtype
     return &descriptor;
 }
 
-/*
- * USB notification callback that does nothing.  Needed to work around bugs in
- * some USB LLDs that fail to resume the waiting thread when the notification
- * callback pointer is NULL.
+/* ---------------------------------------------------------
+ *                    HID report queues
+ * ---------------------------------------------------------
  */
-static void dummy_usb_cb(USBDriver *usbp, usbep_t ep) {
-    (void)usbp;
-    (void)ep;
+
+/* Every HID IN endpoint gets a small FIFO of reports. Senders copy their
+ * report into it and return; the IN-complete callback starts the next
+ * transfer, so a burst of reports goes out one per polling interval with no
+ * intermediate state lost. When a FIFO is full, the sender waits for a slot
+ * to free up as it did before the queues existed, unless its report is the
+ * same as the newest pending one.
+ */
+
+#ifndef USB_REPORT_QUEUE_TIMEOUT_MS
+#    define USB_REPORT_QUEUE_TIMEOUT_MS 10
+#endif
+
+enum usb_report_queues {
+#ifndef KEYBOARD_SHARED_EP
+    KEYBOARD_REPORT_QUEUE,
+#endif
+#if defined(MOUSE_ENABLE) && !defined(MOUSE_SHARED_EP)
+    MOUSE_REPORT_QUEUE,
+#endif
+#ifdef SHARED_EP_ENABLE
+    SHARED_REPORT_QUEUE,
+#endif
+#if defined(JOYSTICK_ENABLE) && !defined(JOYSTICK_SHARED_EP)
+    JOYSTICK_REPORT_QUEUE,
+#endif
+#if defined(DIGITIZER_ENABLE) && !defined(DIGITIZER_SHARED_EP)
+    DIGITIZER_REPORT_QUEUE,
+#endif
+    NUM_REPORT_QUEUES
+};
+
+static usb_report_queue_t report_queues[NUM_REPORT_QUEUES];
+
+static usb_report_queue_t *usb_report_queue_get(usbep_t ep) {
+    switch (ep) {
+#ifndef KEYBOARD_SHARED_EP
+        case KEYBOARD_IN_EPNUM:
+            return &report_queues[KEYBOARD_REPORT_QUEUE];
+#endif
+#if defined(MOUSE_ENABLE) && !defined(MOUSE_SHARED_EP)
+        case MOUSE_IN_EPNUM:
+            return &report_queues[MOUSE_REPORT_QUEUE];
+#endif
+#ifdef SHARED_EP_ENABLE
+        case SHARED_IN_EPNUM:
+            return &report_queues[SHARED_REPORT_QUEUE];
+#endif
+#if defined(JOYSTICK_ENABLE) && !defined(JOYSTICK_SHARED_EP)
+        case JOYSTICK_IN_EPNUM:
+            return &report_queues[JOYSTICK_REPORT_QUEUE];
+#endif
+#if defined(DIGITIZER_ENABLE) && !defined(DIGITIZER_SHARED_EP)
+        case DIGITIZER_IN_EPNUM:
+            return &report_queues[DIGITIZER_REPORT_QUEUE];
+#endif
+        default:
+            return NULL;
+    }
+}
+
+/* Drops everything queued, for when the host has reset the endpoints.
+ * Called from a locked state. */
+static void usb_report_queues_resetI(void) {
+    for (int i = 0; i < NUM_REPORT_QUEUES; i++) {
+        usb_report_queue_reset(&report_queues[i]);
+    }
+}
+
+/* Starts transmitting the oldest queued report, if any.
+ * Called from a locked state with the endpoint idle. */
+static void usb_report_queue_startI(USBDriver *usbp, usbep_t ep, usb_report_queue_t *queue) {
+    uint8_t       size;
+    usb_report_t *report = usb_report_queue_peek(queue, &size);
+    if (report == NULL) {
+        return;
+    }
+    queue->in_flight = true;
+    usbStartTransmitI(usbp, ep, (uint8_t *)report, size);
+}
+
+/* Whether a report that repeats the newest pending one may be dropped when
+ * the queue is full. Relative mouse motion adds up, so it never is. */
+static bool usb_report_mergeable(usbep_t ep, const uint8_t *report) {
+#ifdef USB_REPORT_QUEUE_NO_MERGE
+    return false;
+#endif
+#ifdef SHARED_EP_ENABLE
+    if (ep == SHARED_IN_EPNUM) {
+        return report[0] != REPORT_ID_MOUSE;
+    }
+#endif
+#if defined(MOUSE_ENABLE) && !defined(MOUSE_SHARED_EP)
+    if (ep == MOUSE_IN_EPNUM) {
+        return false;
+    }
+#endif
+    return true;
+}
+
+/* IN-complete callback for the HID endpoints (called from ISR, unlocked state).
+ * Never leave these NULL: some USB LLDs fail to resume the waiting thread
+ * when the notification callback pointer is NULL. */
+static void usb_report_in_cb(USBDriver *usbp, usbep_t ep) {
+    usb_report_queue_t *queue = usb_report_queue_get(ep);
+
+    osalSysLockFromISR();
+    if (queue->in_flight) {
+        queue->in_flight = false;
+        usb_report_queue_pop(queue);
+    }
+    usb_report_queue_startI(usbp, ep, queue);
+    osalSysUnlockFromISR();
+}
+
+bool usb_report_queue_get_stats(uint8_t endpoint, usb_report_queue_stats_t *stats) {
+    usb_report_queue_t *queue = usb_report_queue_get(endpoint);
+    if (queue == NULL) {
+        return false;
+    }
+    osalSysLock();
+    *stats       = queue->stats;
+    stats->depth = queue->count;
+    osalSysUnlock();
+    return true;
+}
+
+void usb_report_queue_clear_stats(void) {
+    osalSysLock();
+    for (int i = 0; i < NUM_REPORT_QUEUES; i++) {
+        report_queues[i].stats           = (usb_report_queue_stats_t){0};
+        report_queues[i].stats.max_depth = report_queues[i].count;
+    }
+    osalSysUnlock();
 }
 
 #ifndef KEYBOARD_SHARED_EP
@@ -135,7 +269,7 @@ static USBInEndpointState kbd_ep_state;
 static const USBEndpointConfig kbd_ep_config = {
     USB_EP_MODE_TYPE_INTR,  /* Interrupt EP */
     NULL,                   /* SETUP packet notification callback */
-    dummy_usb_cb,           /* IN notification callback */
+    usb_report_in_cb,       /* IN notification callback */
     NULL,                   /* OUT notification callback */
     KEYBOARD_EPSIZE,        /* IN maximum packet size */
     0,                      /* OUT maximum packet size */
@@ -153,7 +287,7 @@ static USBInEndpointState mouse_ep_state;
 static const USBEndpointConfig mouse_ep_config = {
     USB_EP_MODE_TYPE_INTR,  /* Interrupt EP */
     NULL,                   /* SETUP packet notification callback */
-    dummy_usb_cb,           /* IN notification callback */
+    usb_report_in_cb,       /* IN notification callback */
     NULL,                   /* OUT notification callback */
     MOUSE_EPSIZE,           /* IN maximum packet size */
     0,                      /* OUT maximum packet size */
@@ -171,7 +305,7 @@ static USBInEndpointState shared_ep_state;
 static const USBEndpointConfig shared_ep_config = {
     USB_EP_MODE_TYPE_INTR,  /* Interrupt EP */
     NULL,                   /* SETUP packet notification callback */
-    dummy_usb_cb,           /* IN notification callback */
+    usb_report_in_cb,       /* IN notification callback */
     NULL,                   /* OUT notification callback */
     SHARED_EPSIZE,          /* IN maximum packet size */
     0,                      /* OUT maximum packet size */
@@ -189,7 +323,7 @@ static USBInEndpointState joystick_ep_state;
 static const USBEndpointConfig joystick_ep_config = {
     USB_EP_MODE_TYPE_INTR,  /* Interrupt EP */
     NULL,                   /* SETUP packet notification callback */
-    dummy_usb_cb,           /* IN notification callback */
+    usb_report_in_cb,       /* IN notification callback */
     NULL,                   /* OUT notification callback */
     JOYSTICK_EPSIZE,        /* IN maximum packet size */
     0,                      /* OUT maximum packet size */
@@ -207,7 +341,7 @@ static USBInEndpointState digitizer_ep_state;
 static const USBEndpointConfig digitizer_ep_config = {
     USB_EP_MODE_TYPE_INTR,  /* Interrupt EP */
     NULL,                   /* SETUP packet notification callback */
-    dummy_usb_cb,           /* IN notification callback */
+    usb_report_in_cb,       /* IN notification callback */
     NULL,                   /* OUT notification callback */
     DIGITIZER_EPSIZE,       /* IN maximum packet size */
     0,                      /* OUT maximum packet size */
@@ -464,11 +598,15 @@ void usb_event_queue_task(void) {
         switch (event) {
             case USB_EVENT_SUSPEND:
                 last_suspend_state = true;
+                threaded_tasks_lock();
                 usb_event_suspend_handler();
+                threaded_tasks_unlock();
                 break;
             case USB_EVENT_WAKEUP:
                 last_suspend_state = false;
+                threaded_tasks_lock();
                 usb_event_wakeup_handler();
+                threaded_tasks_unlock();
                 break;
             case USB_EVENT_CONFIGURED:
                 usb_device_state_set_configuration(USB_DRIVER.configuration != 0, USB_DRIVER.configuration);
@@ -494,6 +632,7 @@ static void usb_event_cb(USBDriver *usbp, usbevent_t event) {
 
         case USB_EVENT_CONFIGURED:
             osalSysLockFromISR();
+            usb_report_queues_resetI();
             /* Enable the endpoints specified into the configuration. */
 #ifndef KEYBOARD_SHARED_EP
             usbInitEndpointI(usbp, KEYBOARD_IN_EPNUM, &kbd_ep_config);
@@ -534,6 +673,11 @@ static void usb_event_cb(USBDriver *usbp, usbevent_t event) {
             /* Falls into.*/
         case USB_EVENT_RESET:
             usb_event_queue_enqueue(event);
+            if (event != USB_EVENT_SUSPEND) {
+                osalSysLockFromISR();
+                usb_report_queues_resetI();
+                osalSysUnlockFromISR();
+            }
             for (int i = 0; i < NUM_USB_DRIVERS; i++) {
                 chSysLockFromISR();
                 /* Disconnection event on suspend.*/
@@ -813,24 +957,37 @@ uint8_t keyboard_leds(void) {
     return keyboard_led_state;
 }
 
+/* Queue a report on a HID IN endpoint, starting the transfer right away if
+ * the endpoint is idle.
+ * not callable from ISR or locked state */
 void send_report(uint8_t endpoint, void *report, size_t size) {
+    usb_report_queue_t *queue = usb_report_queue_get(endpoint);
+
     osalSysLock();
     if (usbGetDriverStateI(&USB_DRIVER) != USB_ACTIVE) {
         osalSysUnlock();
         return;
     }
 
-    if (usbGetTransmitStatusI(&USB_DRIVER, endpoint)) {
+    bool mergeable = usb_report_mergeable(endpoint, report);
+    while (!usb_report_queue_push(queue, report, size, mergeable)) {
         /* Need to either suspend, or loop and call unlock/lock during
          * every iteration - otherwise the system will remain locked,
          * no interrupts served, so USB not going through as well.
          * Note: for suspend, need USB_USE_WAIT == TRUE in halconf.h */
-        if (osalThreadSuspendTimeoutS(&(&USB_DRIVER)->epc[endpoint]->in_state->thread, TIME_MS2I(10)) == MSG_TIMEOUT) {
+        queue->stats.stalls++;
+        if (osalThreadSuspendTimeoutS(&(&USB_DRIVER)->epc[endpoint]->in_state->thread, TIME_MS2I(USB_REPORT_QUEUE_TIMEOUT_MS)) == MSG_TIMEOUT) {
+            queue->stats.dropped++;
             osalSysUnlock();
             return;
         }
     }
-    usbStartTransmitI(&USB_DRIVER, endpoint, report, size);
+
+    /* The idle timer may be using the endpoint outside of the queue, in
+     * which case its IN-complete callback picks this report up. */
+    if (!queue->in_flight && !usbGetTransmitStatusI(&USB_DRIVER, endpoint)) {
+        usb_report_queue_startI(&USB_DRIVER, endpoint, queue);
+    }
     osalSysUnlock();
 }
 
@@ -930,6 +1087,26 @@ int8_t sendchar(uint8_t c) {
     return result;
 }
 
+#    ifdef CONSOLE_TRACE_ENABLE
+// Queue whole trace frames at once, dropping them rather than stalling the
+// main loop when the console is busy or nobody is listening. A frame is only
+// written if it fits, since a partial frame would corrupt the next one.
+bool console_trace_send(const uint8_t *data, uint8_t length) {
+    output_buffers_queue_t *obqp = &drivers.console_driver.driver.obqueue;
+
+    // The buffer being filled is not counted, as the SOF flush may post it
+    // before the write. Free space only grows until the write below.
+    osalSysLock();
+    size_t space = (bqSpaceI(obqp) - (obqp->ptr != NULL ? 1 : 0)) * (obqp->bsize - sizeof(size_t));
+    osalSysUnlock();
+
+    if (space < length) {
+        return false;
+    }
+    return chnWriteTimeout(&drivers.console_driver.driver, data, length, TIME_IMMEDIATE) == length;
+}
+#    endif
+
 // Just a dummy function for now, this could be exposed as a weak function
 // Or connected to the actual QMK console
 static void console_receive(uint8_t *data, uint8_t length) {
@@ -1003,10 +1180,53 @@ void midi_ep_task(void) {
 
 #ifdef VIRTSER_ENABLE
 
+#    include "bytequeue.h"
+
+// must be a power of two
+#    ifndef VIRTSER_TX_QUEUE_LENGTH
+#        define VIRTSER_TX_QUEUE_LENGTH 128
+#    endif
+_Static_assert(VIRTSER_TX_QUEUE_LENGTH <= 256 && (VIRTSER_TX_QUEUE_LENGTH & (VIRTSER_TX_QUEUE_LENGTH - 1)) == 0, "VIRTSER_TX_QUEUE_LENGTH must be a power of two no larger than 256");
+
+static uint8_t     virtser_tx_data[VIRTSER_TX_QUEUE_LENGTH];
+static byteQueue_t virtser_tx_queue = BYTEQUEUE_INITIALIZER(virtser_tx_data);
+
 void virtser_init(void) {}
 
+/* Hand as much of the transmit queue to the CDC endpoint as it will take
+ * without blocking, a whole packet at a time.
+ */
+static void virtser_flush(void) {
+    uint8_t buffer[CDC_EPSIZE];
+    uint8_t count;
+    while ((count = bytequeue_peek(&virtser_tx_queue, buffer, sizeof(buffer))) > 0) {
+        size_t sent = chnWriteTimeout(&drivers.serial_driver.driver, buffer, count, TIME_IMMEDIATE);
+        bytequeue_remove(&virtser_tx_queue, sent);
+        if (sent < count) {
+            break;
+        }
+    }
+}
+
 void virtser_send(const uint8_t byte) {
-    chnWrite(&drivers.serial_driver.driver, &byte, 1);
+    if (!bytequeue_enqueue(&virtser_tx_queue, byte)) {
+        // queue is full, so fall back to waiting on the endpoint
+        uint8_t buffer[CDC_EPSIZE];
+        uint8_t count;
+        while ((count = bytequeue_dequeue(&virtser_tx_queue, buffer, sizeof(buffer))) > 0) {
+            chnWrite(&drivers.serial_driver.driver, buffer, count);
+        }
+        chnWrite(&drivers.serial_driver.driver, &byte, 1);
+    }
+}
+
+bool virtser_send_packet(const uint8_t *data, uint8_t length) {
+    return bytequeue_enqueue_bulk(&virtser_tx_queue, data, length);
+}
+
+uint16_t virtser_dropped(void) {
+    // virtser_send() waits on the endpoint instead of dropping
+    return 0;
 }
 
 __attribute__((weak)) void virtser_recv(uint8_t c) {
@@ -1014,6 +1234,8 @@ __attribute__((weak)) void virtser_recv(uint8_t c) {
 }
 
 void virtser_task(void) {
+    virtser_flush();
+
     uint8_t numBytesReceived = 0;
     uint8_t buffer[16];
     do {
@@ -20,6 +20,8 @@
 #include <ch.h>
 #include <hal.h>
 
+#include "usb_report_queue.h"
+
 /* -------------------------
  * General USB driver header
  * -------------------------
@@ -47,6 +49,17 @@ void usb_event_queue_init(void);
 /* Task to dequeue and execute any handlers for the USB events on the main thread */
 void usb_event_queue_task(void);
 
+/* ----------------
+ * HID report queue
+ * ----------------
+ */
+
+/* Read the queue statistics of a HID IN endpoint, returns false for any other endpoint */
+bool usb_report_queue_get_stats(uint8_t endpoint, usb_report_queue_stats_t *stats);
+
+/* Reset the statistics of all HID report queues */
+void usb_report_queue_clear_stats(void);
+
 /* --------------
  * Console header
  * --------------
@@ -0,0 +1,50 @@
+// Copyright 2023 QMK
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include <string.h>
+#include "usb_report_queue.h"
+
+_Static_assert(USB_REPORT_QUEUE_DEPTH >= 2 && USB_REPORT_QUEUE_DEPTH <= 128, "USB_REPORT_QUEUE_DEPTH must be between 2 and 128");
+
+void usb_report_queue_reset(usb_report_queue_t *queue) {
+    queue->tail      = 0;
+    queue->count     = 0;
+    queue->in_flight = false;
+}
+
+bool usb_report_queue_push(usb_report_queue_t *queue, const void *report, uint8_t size, bool mergeable) {
+    if (queue->count == USB_REPORT_QUEUE_DEPTH) {
+        uint8_t newest = (queue->tail + queue->count - 1) % USB_REPORT_QUEUE_DEPTH;
+        if (mergeable && queue->sizes[newest] == size && memcmp(&queue->reports[newest], report, size) == 0) {
+            queue->stats.merged++;
+            return true;
+        }
+        return false;
+    }
+
+    uint8_t head = (queue->tail + queue->count) % USB_REPORT_QUEUE_DEPTH;
+    memcpy(&queue->reports[head], report, size);
+    queue->sizes[head] = size;
+    queue->count++;
+    queue->stats.queued++;
+    if (queue->count > queue->stats.max_depth) {
+        queue->stats.max_depth = queue->count;
+    }
+    return true;
+}
+
+usb_report_t *usb_report_queue_peek(usb_report_queue_t *queue, uint8_t *size) {
+    if (queue->count == 0) {
+        return NULL;
+    }
+    *size = queue->sizes[queue->tail];
+    return &queue->reports[queue->tail];
+}
+
+void usb_report_queue_pop(usb_report_queue_t *queue) {
+    if (queue->count == 0) {
+        return;
+    }
+    queue->tail = (queue->tail + 1) % USB_REPORT_QUEUE_DEPTH;
+    queue->count--;
+}
@@ -0,0 +1,77 @@
+// Copyright 2023 QMK
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "report.h"
+
+/* A small FIFO of HID reports for one IN endpoint. It does no locking of its
+ * own, callers serialise access to it.
+ */
+
+#ifndef USB_REPORT_QUEUE_DEPTH
+#    define USB_REPORT_QUEUE_DEPTH 4
+#endif
+
+typedef union {
+    uint32_t          align; /* some LLDs copy IN buffers a word at a time */
+    report_keyboard_t keyboard;
+#ifdef NKRO_ENABLE
+    report_nkro_t nkro;
+#endif
+#ifdef EXTRAKEY_ENABLE
+    report_extra_t extra;
+#endif
+#ifdef PROGRAMMABLE_BUTTON_ENABLE
+    report_programmable_button_t programmable_button;
+#endif
+#ifdef MOUSE_ENABLE
+    report_mouse_t mouse;
+#endif
+#ifdef DIGITIZER_ENABLE
+    report_digitizer_t digitizer;
+#endif
+#ifdef JOYSTICK_ENABLE
+    report_joystick_t joystick;
+#endif
+} usb_report_t;
+
+typedef struct {
+    uint32_t queued;    /* reports accepted into the queue */
+    uint32_t merged;    /* reports dropped because the newest pending one was identical */
+    uint32_t dropped;   /* reports lost after waiting for space timed out */
+    uint32_t stalls;    /* times a sender had to wait for space */
+    uint8_t  depth;     /* reports currently queued, including the one being sent */
+    uint8_t  max_depth; /* highest depth seen since the stats were last cleared */
+} usb_report_queue_stats_t;
+
+typedef struct {
+    usb_report_t             reports[USB_REPORT_QUEUE_DEPTH];
+    uint8_t                  sizes[USB_REPORT_QUEUE_DEPTH];
+    uint8_t                  tail;      /* oldest report, the one on the wire while in_flight */
+    uint8_t                  count;     /* reports waiting, including the one on the wire */
+    bool                     in_flight; /* the endpoint is transmitting reports[tail] */
+    usb_report_queue_stats_t stats;
+} usb_report_queue_t;
+
+/** \brief Empties the queue, keeping its statistics. */
+void usb_report_queue_reset(usb_report_queue_t *queue);
+
+/** \brief Appends a copy of a report.
+ *
+ * When the queue is full, a mergeable report that is byte for byte the same
+ * as the newest pending one is dropped, as sending it again would not change
+ * the host's state. Reports that differ are never merged, so every
+ * intermediate state reaches the host.
+ *
+ * \return false if the queue is full and the caller has to wait for space
+ */
+bool usb_report_queue_push(usb_report_queue_t *queue, const void *report, uint8_t size, bool mergeable);
+
+/** \brief Returns the oldest queued report and its size, or NULL if the queue is empty. */
+usb_report_t *usb_report_queue_peek(usb_report_queue_t *queue, uint8_t *size);
+
+/** \brief Removes the oldest queued report. */
+void usb_report_queue_pop(usb_report_queue_t *queue);
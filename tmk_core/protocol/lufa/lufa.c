@@ -57,6 +57,13 @@
 
 #ifdef VIRTSER_ENABLE
 #    include "virtser.h"
+#    include "bytequeue.h"
+
+// must be a power of two
+#    ifndef VIRTSER_TX_QUEUE_LENGTH
+#        define VIRTSER_TX_QUEUE_LENGTH 64
+#    endif
+_Static_assert(VIRTSER_TX_QUEUE_LENGTH <= 256 && (VIRTSER_TX_QUEUE_LENGTH & (VIRTSER_TX_QUEUE_LENGTH - 1)) == 0, "VIRTSER_TX_QUEUE_LENGTH must be a power of two no larger than 256");
 #endif
 
 #ifdef MIDI_ENABLE
@@ -737,11 +744,58 @@ void virtser_recv(uint8_t c) {
     // Ignore by default
 }
 
+/* Bytes are queued by virtser_send() and written to the CDC endpoint a bank
+ * at a time by virtser_task(), rather than as one USB packet per byte.
+ */
+static uint8_t     virtser_tx_data[VIRTSER_TX_QUEUE_LENGTH];
+static byteQueue_t virtser_tx_queue = BYTEQUEUE_INITIALIZER(virtser_tx_data);
+static uint16_t    virtser_tx_dropped = 0;
+
+/** \brief Virtual Serial Flush
+ *
+ * Write all queued bytes to the CDC IN endpoint, giving up if the host stops reading.
+ */
+static void virtser_flush(void) {
+    if (!bytequeue_length(&virtser_tx_queue)) {
+        return;
+    }
+
+    uint8_t ep = Endpoint_GetCurrentEndpoint();
+
+    Endpoint_SelectEndpoint(cdc_device.Config.DataINEndpoint.Address);
+
+    if (!Endpoint_IsEnabled() || !Endpoint_IsConfigured()) {
+        Endpoint_SelectEndpoint(ep);
+        return;
+    }
+
+    while (bytequeue_length(&virtser_tx_queue)) {
+        uint8_t timeout = 255;
+        while (timeout-- && !Endpoint_IsReadWriteAllowed())
+            _delay_us(40);
+
+        if (!Endpoint_IsReadWriteAllowed()) {
+            break;
+        }
+
+        while (bytequeue_length(&virtser_tx_queue) && Endpoint_IsReadWriteAllowed()) {
+            Endpoint_Write_8(bytequeue_get(&virtser_tx_queue, 0));
+            bytequeue_remove(&virtser_tx_queue, 1);
+        }
+
+        Endpoint_ClearIN();
+    }
+
+    Endpoint_SelectEndpoint(ep);
+}
+
 /** \brief Virtual Serial Task
  *
  * FIXME: Needs doc
  */
 void virtser_task(void) {
+    virtser_flush();
+
     uint16_t count = CDC_Device_BytesReceived(&cdc_device);
     uint8_t  ch;
     for (; count; --count) {
@@ -751,33 +805,36 @@ void virtser_task(void) {
 }
 /** \brief Virtual Serial Send
  *
- * FIXME: Needs doc
+ * Queue a byte for sending, dropping it if the host has not opened the port.
+ * If the queue is still full after flushing, the host has stopped reading and
+ * the byte is dropped and counted.
  */
 void virtser_send(const uint8_t byte) {
-    uint8_t timeout = 255;
-    uint8_t ep      = Endpoint_GetCurrentEndpoint();
-
     if (cdc_device.State.ControlLineStates.HostToDevice & CDC_CONTROL_LINE_OUT_DTR) {
-        /* IN packet */
-        Endpoint_SelectEndpoint(cdc_device.Config.DataINEndpoint.Address);
-
-        if (!Endpoint_IsEnabled() || !Endpoint_IsConfigured()) {
-            Endpoint_SelectEndpoint(ep);
-            return;
+        if (!bytequeue_enqueue(&virtser_tx_queue, byte)) {
+            virtser_flush();
+            if (!bytequeue_enqueue(&virtser_tx_queue, byte) && virtser_tx_dropped < UINT16_MAX) {
+                virtser_tx_dropped++;
+            }
         }
+    }
+}
 
-        while (timeout-- && !Endpoint_IsReadWriteAllowed())
-            _delay_us(40);
-
-        Endpoint_Write_8(byte);
-        CDC_Device_Flush(&cdc_device);
-
-        if (Endpoint_IsINReady()) {
-            Endpoint_ClearIN();
-        }
+uint16_t virtser_dropped(void) {
+    return virtser_tx_dropped;
+}
 
-        Endpoint_SelectEndpoint(ep);
+/** \brief Virtual Serial Send Packet
+ *
+ * Queue a whole packet without waiting on the endpoint. Returns false if it
+ * does not fit, in which case nothing was queued. Like virtser_send(), the
+ * packet is discarded if the host has not opened the port.
+ */
+bool virtser_send_packet(const uint8_t *data, uint8_t length) {
+    if (!(cdc_device.State.ControlLineStates.HostToDevice & CDC_CONTROL_LINE_OUT_DTR)) {
+        return true;
     }
+    return bytequeue_enqueue_bulk(&virtser_tx_queue, data, length);
 }
 #endif
 
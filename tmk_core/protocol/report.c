@@ -32,39 +32,110 @@ static int8_t cb_tail  = 0;
 static int8_t cb_count = 0;
 #endif
 
+#ifdef NKRO_ENABLE
+#    if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#        error "NKRO word-wide scans assume a little-endian target"
+#    endif
+
+// The NKRO bitmap is walked 32 bits at a time. bits[] sits at an odd offset
+// inside a packed struct, so words are assembled with memcpy, which the
+// compiler lowers to plain loads wherever unaligned access is allowed.
+#    define NKRO_REPORT_WORDS (NKRO_REPORT_BITS / sizeof(uint32_t))
+
+static inline uint32_t nkro_report_word(const report_nkro_t* nkro_report, uint8_t index) {
+    uint32_t word;
+    memcpy(&word, &nkro_report->bits[index * sizeof(word)], sizeof(word));
+    return word;
+}
+
+static inline bool nkro_report_has_bit(const report_nkro_t* nkro_report, uint8_t code) {
+    return nkro_report->bits[code >> 3] & 1 << (code & 7);
+}
+
+static inline bool nkro_report_active(void) {
+    return keyboard_protocol && keymap_config.nkro;
+}
+
+// While NKRO is active only the bitmap is kept up to date, the 6KRO key array
+// is rebuilt from it the next time it is needed.
+static bool keys_stale = false;
+#endif
+
+/** \brief Brings the 6KRO key array up to date
+ *
+ * Keys pressed while NKRO was active are added in keycode order, up to
+ * KEYBOARD_REPORT_KEYS of them.
+ */
+void sync_6kro_report(void) {
+#ifdef NKRO_ENABLE
+    if (!keys_stale) {
+        return;
+    }
+    keys_stale = false;
+#    ifdef RING_BUFFERED_6KRO_REPORT_ENABLE
+    cb_head = cb_tail = cb_count = 0;
+#    endif
+    memset(keyboard_report->keys, 0, sizeof(keyboard_report->keys));
+
+    uint8_t count = 0;
+    for (uint8_t i = 0; i < NKRO_REPORT_BITS; i++) {
+        uint8_t bits = nkro_report->bits[i];
+        while (bits && count < KEYBOARD_REPORT_KEYS) {
+            add_key_byte(keyboard_report, i << 3 | __builtin_ctz(bits));
+            bits &= bits - 1;
+            count++;
+        }
+    }
+#endif
+}
+
 /** \brief has_anykey
  *
- * FIXME: Needs doc
+ * Returns the number of keys held in the active keyboard report, or 0 if none are.
  */
 uint8_t has_anykey(void) {
-    uint8_t  cnt = 0;
-    uint8_t* p   = keyboard_report->keys;
-    uint8_t  lp  = sizeof(keyboard_report->keys);
+    uint8_t cnt = 0;
 #ifdef NKRO_ENABLE
-    if (keyboard_protocol && keymap_config.nkro) {
-        p  = nkro_report->bits;
-        lp = sizeof(nkro_report->bits);
+    if (nkro_report_active()) {
+        for (uint8_t i = 0; i < NKRO_REPORT_WORDS; i++) {
+            cnt += __builtin_popcountl(nkro_report_word(nkro_report, i));
+        }
+        for (uint8_t i = NKRO_REPORT_WORDS * sizeof(uint32_t); i < NKRO_REPORT_BITS; i++) {
+            cnt += __builtin_popcount(nkro_report->bits[i]);
+        }
+        return cnt;
     }
 #endif
-    while (lp--) {
-        if (*p++) cnt++;
+    sync_6kro_report();
+    for (uint8_t i = 0; i < KEYBOARD_REPORT_KEYS; i++) {
+        if (keyboard_report->keys[i]) cnt++;
     }
     return cnt;
 }
 
 /** \brief get_first_key
  *
- * FIXME: Needs doc
+ * Returns the lowest keycode held in the NKRO report, or the oldest one held in
+ * the 6KRO report. Returns KC_NO if no key is held.
  */
 uint8_t get_first_key(void) {
 #ifdef NKRO_ENABLE
-    if (keyboard_protocol && keymap_config.nkro) {
-        uint8_t i = 0;
-        for (; i < NKRO_REPORT_BITS && !nkro_report->bits[i]; i++)
-            ;
-        return i << 3 | biton(nkro_report->bits[i]);
+    if (nkro_report_active()) {
+        for (uint8_t i = 0; i < NKRO_REPORT_WORDS; i++) {
+            uint32_t word = nkro_report_word(nkro_report, i);
+            if (word) {
+                return i * 32 + __builtin_ctzl(word);
+            }
+        }
+        for (uint8_t i = NKRO_REPORT_WORDS * sizeof(uint32_t); i < NKRO_REPORT_BITS; i++) {
+            if (nkro_report->bits[i]) {
+                return i << 3 | __builtin_ctz(nkro_report->bits[i]);
+            }
+        }
+        return KC_NO;
     }
 #endif
+    sync_6kro_report();
 #ifdef RING_BUFFERED_6KRO_REPORT_ENABLE
     uint8_t i = cb_head;
     do {
@@ -89,14 +160,20 @@ bool is_key_pressed(uint8_t key) {
         return false;
     }
 #ifdef NKRO_ENABLE
-    if (keyboard_protocol && keymap_config.nkro) {
-        if ((key >> 3) < NKRO_REPORT_BITS) {
-            return nkro_report->bits[key >> 3] & 1 << (key & 7);
-        } else {
+    if ((key >> 3) < NKRO_REPORT_BITS) {
+        // The bitmap tracks every held key whichever report is active, so a
+        // clear bit answers for the 6KRO report too without scanning it.
+        if (!nkro_report_has_bit(nkro_report, key)) {
             return false;
         }
+        if (nkro_report_active()) {
+            return true;
+        }
+    } else if (nkro_report_active()) {
+        return false;
     }
 #endif
+    sync_6kro_report();
     for (int i = 0; i < KEYBOARD_REPORT_KEYS; i++) {
         if (keyboard_report->keys[i] == key) {
             return true;
@@ -239,43 +316,60 @@ void del_key_bit(report_nkro_t* nkro_report, uint8_t code) {
 
 /** \brief add key to report
  *
- * FIXME: Needs doc
+ * With NKRO enabled the bitmap tracks every held key whichever report is being
+ * sent, and doubles as the membership test so repeated presses never scan the
+ * 6KRO array. That array is only updated while it is the one being sent.
  */
 void add_key_to_report(uint8_t key) {
 #ifdef NKRO_ENABLE
-    if (keyboard_protocol && keymap_config.nkro) {
+    if ((key >> 3) < NKRO_REPORT_BITS) {
+        if (nkro_report_has_bit(nkro_report, key)) {
+            return;
+        }
         add_key_bit(nkro_report, key);
+    }
+    if (nkro_report_active()) {
+        keys_stale = true;
         return;
     }
+    sync_6kro_report();
 #endif
     add_key_byte(keyboard_report, key);
 }
 
 /** \brief del key from report
  *
- * FIXME: Needs doc
+ * Removes the key from the NKRO bitmap and, unless NKRO is active, from the
+ * 6KRO array; see add_key_to_report().
  */
 void del_key_from_report(uint8_t key) {
 #ifdef NKRO_ENABLE
-    if (keyboard_protocol && keymap_config.nkro) {
+    if ((key >> 3) < NKRO_REPORT_BITS) {
+        if (!nkro_report_has_bit(nkro_report, key)) {
+            return;
+        }
         del_key_bit(nkro_report, key);
+    }
+    if (nkro_report_active()) {
+        keys_stale = true;
         return;
     }
+    sync_6kro_report();
 #endif
     del_key_byte(keyboard_report, key);
 }
 
 /** \brief clear key from report
  *
- * FIXME: Needs doc
+ * Clears all keys, but not mods, from both report formats.
  */
 void clear_keys_from_report(void) {
-    // not clear mods
 #ifdef NKRO_ENABLE
-    if (keyboard_protocol && keymap_config.nkro) {
-        memset(nkro_report->bits, 0, sizeof(nkro_report->bits));
-        return;
-    }
+    memset(nkro_report->bits, 0, sizeof(nkro_report->bits));
+    keys_stale = false;
+#endif
+#ifdef RING_BUFFERED_6KRO_REPORT_ENABLE
+    cb_head = cb_tail = cb_count = 0;
 #endif
     memset(keyboard_report->keys, 0, sizeof(keyboard_report->keys));
 }
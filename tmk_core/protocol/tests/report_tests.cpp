@@ -0,0 +1,235 @@
+// Copyright 2023 QMK
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "gtest/gtest.h"
+
+extern "C" {
+#include "report.h"
+#include "host.h"
+#include "keycode.h"
+#include "keycode_config.h"
+
+static report_keyboard_t test_keyboard_report;
+static report_nkro_t     test_nkro_report;
+
+report_keyboard_t *keyboard_report = &test_keyboard_report;
+report_nkro_t     *nkro_report     = &test_nkro_report;
+uint8_t            keyboard_protocol;
+keymap_config_t    keymap_config;
+}
+
+class Report : public testing::Test {
+   protected:
+    void SetUp() override {
+        keyboard_protocol = 1;
+        set_nkro(false);
+        clear_keys_from_report();
+    }
+
+    void set_nkro(bool nkro) {
+        keymap_config.nkro = nkro;
+    }
+
+    uint8_t keys_in_6kro_report(void) {
+        sync_6kro_report();
+        uint8_t count = 0;
+        for (uint8_t i = 0; i < KEYBOARD_REPORT_KEYS; i++) {
+            if (keyboard_report->keys[i]) count++;
+        }
+        return count;
+    }
+
+    bool is_in_6kro_report(uint8_t key) {
+        sync_6kro_report();
+        for (uint8_t i = 0; i < KEYBOARD_REPORT_KEYS; i++) {
+            if (keyboard_report->keys[i] == key) return true;
+        }
+        return false;
+    }
+};
+
+TEST_F(Report, AddAndDelIn6kro) {
+    add_key_to_report(KC_B);
+    add_key_to_report(KC_A);
+    add_key_to_report(KC_A);
+    EXPECT_EQ(has_anykey(), 2);
+    EXPECT_EQ(get_first_key(), KC_B);
+    EXPECT_TRUE(is_key_pressed(KC_A));
+    EXPECT_TRUE(is_key_pressed(KC_B));
+    EXPECT_FALSE(is_key_pressed(KC_C));
+
+    del_key_from_report(KC_A);
+    EXPECT_EQ(has_anykey(), 1);
+    EXPECT_EQ(get_first_key(), KC_B);
+    EXPECT_FALSE(is_key_pressed(KC_A));
+
+    del_key_from_report(KC_B);
+    EXPECT_EQ(has_anykey(), 0);
+    EXPECT_EQ(get_first_key(), KC_NO);
+}
+
+TEST_F(Report, AddAndDelInNkro) {
+    set_nkro(true);
+    add_key_to_report(KC_B);
+    add_key_to_report(KC_A);
+    add_key_to_report(KC_A);
+    EXPECT_EQ(has_anykey(), 2);
+    EXPECT_EQ(get_first_key(), KC_A);
+    EXPECT_TRUE(is_key_pressed(KC_A));
+    EXPECT_TRUE(is_key_pressed(KC_B));
+    EXPECT_FALSE(is_key_pressed(KC_C));
+
+    del_key_from_report(KC_A);
+    EXPECT_EQ(has_anykey(), 1);
+    EXPECT_EQ(get_first_key(), KC_B);
+    EXPECT_FALSE(is_key_pressed(KC_A));
+
+    del_key_from_report(KC_B);
+    EXPECT_EQ(has_anykey(), 0);
+    EXPECT_EQ(get_first_key(), KC_NO);
+}
+
+TEST_F(Report, MoreThanSixKeysIn6kro) {
+    const uint8_t keys[] = {KC_A, KC_B, KC_C, KC_D, KC_E, KC_F, KC_G, KC_H};
+    for (uint8_t key : keys) {
+        add_key_to_report(key);
+    }
+    EXPECT_EQ(has_anykey(), KEYBOARD_REPORT_KEYS);
+    EXPECT_EQ(keys_in_6kro_report(), KEYBOARD_REPORT_KEYS);
+#ifdef RING_BUFFERED_6KRO_REPORT_ENABLE
+    // The oldest keys make way for the newest
+    EXPECT_FALSE(is_key_pressed(KC_A));
+    EXPECT_TRUE(is_key_pressed(KC_H));
+    EXPECT_EQ(get_first_key(), KC_C);
+#else
+    // Keys beyond the sixth are not reported
+    EXPECT_TRUE(is_key_pressed(KC_A));
+    EXPECT_FALSE(is_key_pressed(KC_H));
+    EXPECT_EQ(get_first_key(), KC_A);
+#endif
+
+    for (uint8_t key : keys) {
+        del_key_from_report(key);
+    }
+    EXPECT_EQ(has_anykey(), 0);
+    EXPECT_EQ(keys_in_6kro_report(), 0);
+}
+
+TEST_F(Report, MoreThanSixKeysInNkro) {
+    set_nkro(true);
+    const uint8_t keys[] = {KC_H, KC_G, KC_F, KC_E, KC_D, KC_C, KC_B, KC_A};
+    for (uint8_t key : keys) {
+        add_key_to_report(key);
+    }
+    EXPECT_EQ(has_anykey(), sizeof(keys));
+    EXPECT_EQ(get_first_key(), KC_A);
+    for (uint8_t key : keys) {
+        EXPECT_TRUE(is_key_pressed(key));
+    }
+
+    del_key_from_report(KC_A);
+    EXPECT_EQ(has_anykey(), sizeof(keys) - 1);
+    EXPECT_EQ(get_first_key(), KC_B);
+    EXPECT_FALSE(is_key_pressed(KC_A));
+}
+
+TEST_F(Report, KeysHeldAcrossSwitchToNkro) {
+    add_key_to_report(KC_A);
+    add_key_to_report(KC_B);
+
+    set_nkro(true);
+    EXPECT_EQ(has_anykey(), 2);
+    EXPECT_TRUE(is_key_pressed(KC_A));
+    EXPECT_TRUE(is_key_pressed(KC_B));
+
+    del_key_from_report(KC_A);
+    add_key_to_report(KC_C);
+    EXPECT_EQ(has_anykey(), 2);
+    EXPECT_EQ(get_first_key(), KC_B);
+    EXPECT_FALSE(is_key_pressed(KC_A));
+    EXPECT_TRUE(is_key_pressed(KC_C));
+}
+
+TEST_F(Report, KeysHeldAcrossSwitchTo6kro) {
+    set_nkro(true);
+    add_key_to_report(KC_A);
+    add_key_to_report(KC_B);
+    del_key_from_report(KC_A);
+    add_key_to_report(KC_C);
+
+    set_nkro(false);
+    EXPECT_EQ(has_anykey(), 2);
+    EXPECT_EQ(keys_in_6kro_report(), 2);
+    EXPECT_FALSE(is_key_pressed(KC_A));
+    EXPECT_TRUE(is_key_pressed(KC_B));
+    EXPECT_TRUE(is_key_pressed(KC_C));
+
+    add_key_to_report(KC_D);
+    del_key_from_report(KC_C);
+    EXPECT_EQ(has_anykey(), 2);
+    EXPECT_EQ(get_first_key(), KC_B);
+    EXPECT_FALSE(is_key_pressed(KC_C));
+    EXPECT_TRUE(is_key_pressed(KC_D));
+}
+
+TEST_F(Report, EachQueryCatchesUpAfterSwitchTo6kro) {
+    auto press_in_nkro = [this]() {
+        clear_keys_from_report();
+        set_nkro(true);
+        add_key_to_report(KC_B);
+        set_nkro(false);
+    };
+
+    press_in_nkro();
+    EXPECT_TRUE(is_key_pressed(KC_B));
+    press_in_nkro();
+    EXPECT_EQ(get_first_key(), KC_B);
+    press_in_nkro();
+    EXPECT_EQ(has_anykey(), 1);
+    press_in_nkro();
+    del_key_from_report(KC_B);
+    EXPECT_EQ(keys_in_6kro_report(), 0);
+    press_in_nkro();
+    add_key_to_report(KC_A);
+    EXPECT_EQ(keys_in_6kro_report(), 2);
+}
+
+TEST_F(Report, MoreThanSixKeysHeldAcrossSwitchTo6kro) {
+    set_nkro(true);
+    const uint8_t keys[] = {KC_H, KC_G, KC_F, KC_E, KC_D, KC_C, KC_B, KC_A};
+    for (uint8_t key : keys) {
+        add_key_to_report(key);
+    }
+
+    // The lowest keycodes fill the 6KRO report
+    set_nkro(false);
+    EXPECT_EQ(has_anykey(), KEYBOARD_REPORT_KEYS);
+    EXPECT_TRUE(is_key_pressed(KC_A));
+    EXPECT_TRUE(is_key_pressed(KC_F));
+    EXPECT_FALSE(is_key_pressed(KC_G));
+    EXPECT_EQ(get_first_key(), KC_A);
+
+    // Back in NKRO, every held key is still reported
+    set_nkro(true);
+    EXPECT_EQ(has_anykey(), sizeof(keys));
+    EXPECT_TRUE(is_key_pressed(KC_H));
+
+    for (uint8_t key : keys) {
+        del_key_from_report(key);
+    }
+    set_nkro(false);
+    EXPECT_EQ(has_anykey(), 0);
+    EXPECT_EQ(get_first_key(), KC_NO);
+    EXPECT_EQ(keys_in_6kro_report(), 0);
+}
+
+TEST_F(Report, BootProtocolUses6kro) {
+    set_nkro(true);
+    add_key_to_report(KC_A);
+    add_key_to_report(KC_B);
+
+    keyboard_protocol = 0;
+    EXPECT_TRUE(is_in_6kro_report(KC_A));
+    EXPECT_TRUE(is_in_6kro_report(KC_B));
+    EXPECT_EQ(has_anykey(), 2);
+}
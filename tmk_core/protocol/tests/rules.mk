@@ -0,0 +1,13 @@
+REPORT_COMMON_INC := $(TMK_PATH)/protocol
+
+REPORT_COMMON_SRC := \
+	$(TMK_PATH)/protocol/tests/report_tests.cpp \
+	$(TMK_PATH)/protocol/report.c
+
+report_nkro_DEFS := -DNKRO_ENABLE -DEEPROM_TEST_HARNESS -DNO_DEBUG -DNO_PRINT
+report_nkro_INC := $(REPORT_COMMON_INC)
+report_nkro_SRC := $(REPORT_COMMON_SRC)
+
+report_nkro_ring_buffered_DEFS := -DNKRO_ENABLE -DEEPROM_TEST_HARNESS -DNO_DEBUG -DNO_PRINT -DRING_BUFFERED_6KRO_REPORT_ENABLE
+report_nkro_ring_buffered_INC := $(REPORT_COMMON_INC)
+report_nkro_ring_buffered_SRC := $(REPORT_COMMON_SRC)
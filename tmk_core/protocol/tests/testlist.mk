@@ -0,0 +1,3 @@
+TEST_LIST += \
+	report_nkro \
+	report_nkro_ring_buffered
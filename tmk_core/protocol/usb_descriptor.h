@@ -300,7 +300,12 @@ enum usb_endpoints {
 #define KEYBOARD_EPSIZE 8
 #define SHARED_EPSIZE 32
 #define MOUSE_EPSIZE 16
-#define RAW_EPSIZE 32
+#ifndef RAW_EPSIZE
+#    define RAW_EPSIZE 32
+#endif
+#if RAW_EPSIZE > 64
+#    error "RAW_EPSIZE cannot be larger than 64 on a full speed USB device"
+#endif
 #define CONSOLE_EPSIZE 32
 #define MIDI_STREAM_EPSIZE 64
 #define CDC_NOTIFICATION_EPSIZE 8